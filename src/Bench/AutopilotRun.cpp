@@ -0,0 +1,183 @@
+// Lets the Autopilot play levels 1..N back to back on a headless GameWorld
+// and reports tick-time statistics per level, so the cost of the spawn
+// formulas ramping up with the level is visible under realistic play.
+//
+// Usage: DawnbreakerAutopilot [--levels N] [--seed S] [--max-ticks N]
+//                             [--csv file] [--stop-on-game-over]
+//                             [--trace file] [--telemetry file]
+//                             [--frame-budget ms]
+//
+// A level the bot loses is retried from its start like in the game. On game
+// over the bot gets a continue (fresh lives, same level) so it can play
+// unattended, unless --stop-on-game-over is given. The run also ends when one
+// attempt exceeds --max-ticks. With --trace the run is recorded as a Chrome
+// trace, so single slow ticks can be inspected in Perfetto; with --telemetry
+// the gameplay telemetry stream is written for DawnbreakerTelemetry. With
+// --frame-budget the FrameGovernor runs as in the game; play, and so the
+// score, must come out the same.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "Autopilot.h"
+#include "GameWorld.h"
+#include "Telemetry.h"
+#include "TraceRecorder.h"
+
+struct LevelResult {
+    int level;
+    int attempts;
+    int continues;
+    int ticks;
+    size_t peakObjects;
+    double meanMs;
+    double p50Ms;
+    double p95Ms;
+    double maxMs;
+};
+
+static double Percentile(const std::vector<double>& sorted, int p) {
+    return sorted[std::min(sorted.size() - 1, sorted.size() * p / 100)];
+}
+
+int main(int argc, char** argv) {
+    int levels = 10;
+    int maxTicks = 20000;
+    long long seed = -1;
+    const char* csvPath = nullptr;
+    bool stopOnGameOver = false;
+    double frameBudget = 0.0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--levels") == 0 && i + 1 < argc) {
+            levels = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc) {
+            maxTicks = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (strcmp(argv[i], "--stop-on-game-over") == 0) {
+            stopOnGameOver = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            TraceRecorder::Instance().Enable(argv[++i]);
+            TraceRecorder::Instance().SetThreadName("autopilot");
+        } else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+            if (!Telemetry::Instance().Enable(argv[++i])) {
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc) {
+            frameBudget = atof(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--levels N] [--seed S] [--max-ticks N]"
+                      << " [--csv file] [--stop-on-game-over] [--trace file] [--telemetry file]"
+                      << " [--frame-budget ms]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    GameWorld world;
+    if (seed >= 0) {
+        world.GetContext().random.SetState(static_cast<unsigned long long>(seed));
+    }
+    world.SetFrameBudget(frameBudget);
+    Autopilot bot(world);
+    world.SetInputSource(&bot);
+    const int lives = world.GetLives();
+
+    std::vector<LevelResult> results;
+    bool over = false;
+    for (int level = 1; level <= levels && !over; level++) {
+        LevelResult result{ level, 1, 0, 0, 0, 0, 0, 0, 0 };
+        std::vector<double> samples;
+        world.SetLevel(level);
+        world.Init();
+        int attemptTicks = 0;
+        while (true) {
+            auto begin = std::chrono::steady_clock::now();
+            LevelStatus status = world.Update();
+            auto end = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+            result.peakObjects = std::max(result.peakObjects, world.GetObjects().size());
+            attemptTicks++;
+
+            if (status == LevelStatus::LEVEL_CLEARED) {
+                world.CleanUp();
+                break;
+            }
+            if (status == LevelStatus::DAWNBREAKER_DESTROYED) {
+                world.CleanUp();
+                if (world.IsGameOver()) {
+                    if (stopOnGameOver) {
+                        std::cout << "game over on level " << level << std::endl;
+                        over = true;
+                        break;
+                    }
+                    result.continues++;
+                    world.SetLives(lives);
+                }
+                result.attempts++;
+                attemptTicks = 0;
+                world.Init();
+                continue;
+            }
+            if (attemptTicks >= maxTicks) {
+                std::cout << "level " << level << " not cleared in " << maxTicks 
+                          << " ticks" << std::endl;
+                world.CleanUp();
+                over = true;
+                break;
+            }
+        }
+
+        double sum = 0.0;
+        for (double s : samples) {
+            sum += s;
+        }
+        std::sort(samples.begin(), samples.end());
+        result.ticks = static_cast<int>(samples.size());
+        result.meanMs = sum / samples.size();
+        result.p50Ms = Percentile(samples, 50);
+        result.p95Ms = Percentile(samples, 95);
+        result.maxMs = samples.back();
+        results.push_back(result);
+
+        std::cout << "level " << std::setw(3) << result.level
+                  << "  attempts " << std::setw(2) << result.attempts
+                  << "  continues " << result.continues
+                  << "  ticks " << std::setw(6) << result.ticks
+                  << "  peak objects " << std::setw(4) << result.peakObjects
+                  << std::fixed << std::setprecision(4)
+                  << "  mean " << result.meanMs << " ms"
+                  << "  p50 " << result.p50Ms << " ms"
+                  << "  p95 " << result.p95Ms << " ms"
+                  << "  max " << result.maxMs << " ms" << std::endl;
+    }
+    std::cout << "score " << world.GetScore() << std::endl;
+    if (world.GetGovernor().IsEnabled()) {
+        world.GetGovernor().Print(std::cout);
+    }
+
+    if (csvPath != nullptr) {
+        std::ofstream csv(csvPath);
+        csv << "level,attempts,continues,ticks,peak_objects,mean_ms,p50_ms,p95_ms,max_ms\n";
+        for (auto& result : results) {
+            csv << result.level << "," << result.attempts << "," << result.continues << "," 
+                << result.ticks << ","
+                << result.peakObjects << "," << result.meanMs << "," << result.p50Ms << ","
+                << result.p95Ms << "," << result.maxMs << "\n";
+        }
+    }
+    if (TraceRecorder::Instance().IsEnabled()) {
+        TraceRecorder::Instance().Write();
+    }
+    if (Telemetry::Instance().IsEnabled()) {
+        Telemetry::Instance().Close();
+        Telemetry::Instance().Print(std::cout);
+    }
+    return over ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,416 @@
+// Microbenchmarks for the hot paths of a tick: collision tests, the random
+// generator, spawn/death churn, render registry bookkeeping, key lookups,
+// status bar formatting and layout, the starfield, and whole ticks at
+// several population sizes.
+//
+// Usage: DawnbreakerBench [--filter substring] [--min-time seconds]
+//                         [--repetitions N] [--json file]
+//
+// Every benchmark is first calibrated until one run takes at least
+// --min-time, then repeated; the fastest and the median run are reported.
+// A summary goes to stderr, the JSON results go to stdout or --json.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GameManager.h"
+#include "GameWorld.h"
+#include "TextRenderer.h"
+
+struct BenchResult {
+    std::string name;
+    long long iterations;
+    double minNs;
+    double medianNs;
+    int liveObjects;    // 0 when the benchmark does not run a world
+};
+
+// Benchmarks write what they computed here so the work cannot be optimized
+// away.
+static volatile long long g_sink = 0;
+
+class BenchRunner {
+
+public:
+
+    BenchRunner(const char* filter, double minTime, int repetitions)
+        : m_filter(filter), m_minTime(minTime), m_repetitions(repetitions), m_results() { }
+
+    bool Wants(const std::string& name) const {
+        return this->m_filter == nullptr || name.find(this->m_filter) != std::string::npos;
+    }
+
+    // body(n) runs the operation n times. Returns nullptr when the filter
+    // skips the benchmark.
+    template<typename Body>
+    BenchResult* Run(const std::string& name, Body body) {
+        if (!this->Wants(name)) {
+            return nullptr;
+        }
+
+        // Grow the iteration count until a run is long enough to time.
+        long long iterations = 1;
+        while (true) {
+            double seconds = this->Time(body, iterations);
+            if (seconds >= this->m_minTime || iterations >= (1LL << 30)) {
+                break;
+            }
+            double scale = seconds > 0.0 ? 1.4 * this->m_minTime / seconds : 100.0;
+            iterations = static_cast<long long>(iterations * std::min(std::max(scale, 2.0), 100.0));
+        }
+
+        std::vector<double> samples;
+        for (int i = 0; i < this->m_repetitions; i++) {
+            samples.push_back(this->Time(body, iterations) * 1e9 / iterations);
+        }
+        std::sort(samples.begin(), samples.end());
+
+        BenchResult result;
+        result.name = name;
+        result.iterations = iterations;
+        result.minNs = samples.front();
+        result.medianNs = samples[samples.size() / 2];
+        result.liveObjects = 0;
+        this->m_results.push_back(result);
+
+        std::cerr << std::left << std::setw(28) << name << std::right
+                  << std::setw(12) << iterations << " iters"
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(14) << result.minNs << " ns/op min"
+                  << std::setw(14) << result.medianNs << " ns/op median" << std::endl;
+        return &this->m_results.back();
+    }
+
+    void WriteJson(std::ostream& out) const {
+        char date[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+        out << "{\n  \"context\": {\n"
+            << "    \"date\": \"" << date << "\",\n"
+            << "    \"min_time_s\": " << this->m_minTime << ",\n"
+            << "    \"repetitions\": " << this->m_repetitions << "\n"
+            << "  },\n  \"benchmarks\": [";
+        for (size_t i = 0; i < this->m_results.size(); i++) {
+            const BenchResult& result = this->m_results[i];
+            out << (i == 0 ? "\n" : ",\n")
+                << "    {\"name\": \"" << result.name << "\""
+                << ", \"iterations\": " << result.iterations
+                << std::fixed << std::setprecision(3)
+                << ", \"ns_per_op_min\": " << result.minNs
+                << ", \"ns_per_op_median\": " << result.medianNs;
+            if (result.liveObjects > 0) {
+                out << ", \"live_objects\": " << result.liveObjects;
+            }
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+private:
+
+    template<typename Body>
+    double Time(Body& body, long long iterations) {
+        auto begin = std::chrono::steady_clock::now();
+        body(iterations);
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - begin).count();
+    }
+
+    const char* m_filter;
+    double m_minTime;
+    int m_repetitions;
+    std::vector<BenchResult> m_results;
+
+};
+
+// The smallest thing the render registry can hold.
+class BenchObject : public ObjectBase {
+
+public:
+
+    BenchObject(int x, int y) : ObjectBase(IMGID_STAR, x, y, 0, 4, 1.0) { }
+    void Update() override { }
+
+};
+
+static void BenchCollision(BenchRunner& runner) {
+    GameWorld world;
+    WorldBase::Scope scope(world);
+
+    // Bullets against ships scattered over the screen, roughly one pair in
+    // twenty overlapping like in a busy level.
+    const int count = 256;
+    std::vector<std::unique_ptr<GameObject>> bullets;
+    std::vector<std::unique_ptr<GameObject>> ships;
+    for (int i = 0; i < count; i++) {
+        bullets.push_back(std::make_unique<BlueBullet>(
+            randInt(0, WINDOW_WIDTH - 1), randInt(0, WINDOW_HEIGHT - 1), 0, 0.5, 5));
+        ships.push_back(std::make_unique<AlphaShip>(
+            randInt(0, WINDOW_WIDTH - 1), randInt(0, WINDOW_HEIGHT - 1), 180, 1.0, 20, 5, 2));
+    }
+    runner.Run("collision_operator_and", [&](long long n) {
+        long long hits = 0;
+        for (long long i = 0; i < n; i++) {
+            hits += *bullets[i % count] & *ships[(i * 7 + i / count) % count];
+        }
+        g_sink = hits;
+    });
+
+    bullets.clear();
+    ships.clear();
+}
+
+static void BenchRandom(BenchRunner& runner) {
+    GameWorld world;
+    WorldBase::Scope scope(world);
+
+    runner.Run("rand_int", [](long long n) {
+        long long sum = 0;
+        for (long long i = 0; i < n; i++) {
+            sum += randInt(1, 100);
+        }
+        g_sink = sum;
+    });
+}
+
+static void BenchChurn(BenchRunner& runner) {
+    // A level 1 world that never ends, so the enemy spawner and the player
+    // stay as they are while bullets come and go.
+    StressConfig config;
+    config.enabled = true;
+
+    GameWorld world;
+    world.SetStressConfig(config);
+    world.Init();
+
+    runner.Run("world_update_idle", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            world.Update();
+        }
+        g_sink = world.GetTick();
+    });
+
+    // Bullets spawned at the top edge die in their first Update() and are
+    // compacted away at the end of the same tick. Subtract world_update_idle
+    // to get the cost of 64 spawns and deaths.
+    const int batch = 64;
+    runner.Run("add_object_churn_64", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            WorldBase::Scope scope(world);
+            for (int b = 0; b < batch; b++) {
+                world.AddObject(std::make_unique<BlueBullet>(
+                    b * 8, WINDOW_HEIGHT, 0, 0.5, 5));
+            }
+            world.Update();
+        }
+        g_sink = world.GetObjects().size();
+    });
+
+    world.CleanUp();
+}
+
+static void BenchRegistry(BenchRunner& runner) {
+    GameWorld world;
+    WorldBase::Scope scope(world);
+
+    // Replace one object out of a full layer per operation, which removes
+    // it from the middle of the registry and appends its successor.
+    const int count = 1024;
+    std::vector<std::unique_ptr<BenchObject>> objects;
+    for (int i = 0; i < count; i++) {
+        objects.push_back(std::make_unique<BenchObject>(i % WINDOW_WIDTH, i % WINDOW_HEIGHT));
+    }
+    runner.Run("registry_insert_erase", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            size_t index = static_cast<size_t>((i * 613) % count);
+            objects[index].reset();
+            objects[index] = std::make_unique<BenchObject>(static_cast<int>(index), 0);
+        }
+        g_sink = world.GetContext().registry.GetObjects(4).size();
+    });
+
+    objects.clear();
+}
+
+static void BenchKeys(BenchRunner& runner) {
+    // The keys a player typically holds while others are polled too.
+    GameManager& manager = GameManager::Instance();
+    manager.KeyDownEvent('w', 0, 0);
+    manager.KeyDownEvent('j', 0, 0);
+
+    const KeyCode keys[] = { KeyCode::UP, KeyCode::LEFT, KeyCode::DOWN, KeyCode::RIGHT,
+                             KeyCode::FIRE1, KeyCode::FIRE2, KeyCode::ENTER, KeyCode::QUIT };
+    const int keyCount = sizeof(keys) / sizeof(keys[0]);
+    runner.Run("game_manager_get_key", [&](long long n) {
+        long long pressed = 0;
+        for (long long i = 0; i < n; i++) {
+            pressed += manager.GetKey(keys[i % keyCount]);
+        }
+        g_sink = pressed;
+    });
+
+    manager.KeyUpEvent('w', 0, 0);
+    manager.KeyUpEvent('j', 0, 0);
+}
+
+static void BenchStatusBar(BenchRunner& runner) {
+    GameWorld world;
+    world.Init();
+
+    runner.Run("status_bar_format", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            world.UpdateStatusBar();
+        }
+        g_sink = world.GetStatusBarMessage().size();
+    });
+
+    world.CleanUp();
+}
+
+static void BenchTextLayout(BenchRunner& runner) {
+    GameWorld world;
+    world.Init();
+    world.UpdateStatusBar();
+
+    // Real metrics need a window; widths like Helvetica 12 in a 512x128
+    // atlas cost the same to lay out.
+    TextRenderer::Metrics metrics;
+    metrics.textureWidth = 512;
+    metrics.textureHeight = 128;
+    metrics.cellWidth = 16;
+    metrics.cellHeight = 20;
+    metrics.descent = 6;
+    metrics.advance.fill(7);
+
+    // What the status bar cost per frame without the string cache.
+    TextRenderer::Vertices vertices;
+    runner.Run("text_layout_status_bar", [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            vertices.clear();
+            TextRenderer::Layout(metrics, -1.0 + 25.0 / WINDOW_WIDTH, -1.0 + 25.0 / WINDOW_HEIGHT,
+                                 world.GetStatusBarMessage().c_str(), false, vertices);
+        }
+        g_sink = vertices.size();
+    });
+
+    world.CleanUp();
+}
+
+static void BenchStars(BenchRunner& runner) {
+    RenderRegistry registry;
+    ParticleSystem particles(registry);
+
+    // A stress-mode starfield: 11 stars enter at the top every tick and as
+    // many leave at the bottom.
+    const int perTick = 11;
+    particles.SetCapacity(perTick * (WINDOW_HEIGHT + 2), ParticleSystem::DEFAULT_EXPLOSIONS);
+    auto tick = [&]() {
+        for (int i = 0; i < perTick; i++) {
+            particles.SpawnStar(i * WINDOW_WIDTH / perTick, WINDOW_HEIGHT - 1, 0.25);
+        }
+        particles.Update();
+    };
+    for (int i = 0; i < WINDOW_HEIGHT + 100; i++) {
+        tick();
+    }
+    runner.Run("starfield_tick_" + std::to_string(particles.GetStarCount()), [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            tick();
+        }
+        g_sink = particles.GetStarCount();
+    });
+}
+
+static void BenchUpdate(BenchRunner& runner, int target) {
+    std::string name = "world_update_" + std::to_string(target);
+    if (!runner.Wants(name)) {
+        return;
+    }
+
+    // Same shape of world as DawnbreakerStress.
+    StressConfig config;
+    config.enabled = true;
+    config.starsPerTick = std::max(1, target / WINDOW_HEIGHT);
+    config.shipCap = std::max(3, target / 100);
+    config.fireInterval = 2;
+    config.autoFire = true;
+    config.enemyFireInterval = 20;
+
+    GameWorld world;
+    world.SetStressConfig(config);
+    world.Init();
+    // Let the starfield fill the whole screen before measuring.
+    for (int i = 0; i < WINDOW_HEIGHT + 100; i++) {
+        world.Update();
+    }
+
+    BenchResult* result = runner.Run(name, [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            world.Update();
+        }
+        g_sink = world.GetTick();
+    });
+    if (result != nullptr) {
+        result->liveObjects = static_cast<int>(
+            world.GetObjects().size() + world.GetParticles().GetCount() + 1);
+    }
+
+    world.CleanUp();
+}
+
+int main(int argc, char** argv) {
+    const char* filter = nullptr;
+    double minTime = 0.2;
+    int repetitions = 3;
+    const char* jsonPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            minTime = std::max(0.001, atof(argv[++i]));
+        } else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) {
+            repetitions = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--filter substring] [--min-time seconds]"
+                      << " [--repetitions N] [--json file]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    BenchRunner runner(filter, minTime, repetitions);
+    BenchCollision(runner);
+    BenchRandom(runner);
+    BenchChurn(runner);
+    BenchRegistry(runner);
+    BenchKeys(runner);
+    BenchStatusBar(runner);
+    BenchTextLayout(runner);
+    BenchStars(runner);
+    for (int target : { 1000, 5000, 10000 }) {
+        BenchUpdate(runner, target);
+    }
+
+    if (jsonPath != nullptr) {
+        std::ofstream json(jsonPath);
+        if (!json) {
+            std::cerr << "Cannot write " << jsonPath << std::endl;
+            return EXIT_FAILURE;
+        }
+        runner.WriteJson(json);
+    } else {
+        runner.WriteJson(std::cout);
+    }
+    return EXIT_SUCCESS;
+}
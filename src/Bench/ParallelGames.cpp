@@ -0,0 +1,147 @@
+// Plays many independent games at once, one GameWorld per game, and reports
+// throughput in games per second for a range of thread counts. Each world
+// owns its registry, RNG and object pool, so games on different threads share
+// nothing mutable and a seeded game plays out the same on any thread count;
+// the final scores are compared against the single-threaded run to prove it.
+//
+// Usage: DawnbreakerParallel [--games N] [--levels N] [--max-threads N]
+//                            [--seed S]
+//
+// Every game is the Autopilot playing from level 1 until it clears --levels
+// levels or loses its last life.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "Autopilot.h"
+#include "GameWorld.h"
+
+struct GameResult {
+    int score;
+    int level;
+    long long ticks;
+};
+
+static GameResult PlayGame(unsigned long long seed, int levels) {
+    GameWorld world;
+    world.GetContext().random.SetState(seed);
+    Autopilot bot(world);
+    world.SetInputSource(&bot);
+
+    GameResult result{ 0, 1, 0 };
+    world.Init();
+    while (true) {
+        LevelStatus status = world.Update();
+        result.ticks++;
+        if (status == LevelStatus::LEVEL_CLEARED) {
+            world.CleanUp();
+            if (world.GetLevel() == levels) {
+                break;
+            }
+            world.SetLevel(world.GetLevel() + 1);
+            world.Init();
+        } else if (status == LevelStatus::DAWNBREAKER_DESTROYED) {
+            world.CleanUp();
+            if (world.IsGameOver()) {
+                break;
+            }
+            world.Init();
+        }
+    }
+    result.score = world.GetScore();
+    result.level = world.GetLevel();
+    return result;
+}
+
+// Plays all games on the given number of threads; returns the wall time.
+static double PlayAll(int threads, int levels, unsigned long long seed, 
+        std::vector<GameResult>& results) {
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t game = next++; game < results.size(); game = next++) {
+            results[game] = PlayGame(seed + game, levels);
+        }
+    };
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++) {
+        pool.emplace_back(worker);
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+int main(int argc, char** argv) {
+    int games = 64;
+    int levels = 3;
+    int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned long long seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            games = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--levels") == 0 && i + 1 < argc) {
+            levels = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--max-threads") == 0 && i + 1 < argc) {
+            maxThreads = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--games N] [--levels N]"
+                      << " [--max-threads N] [--seed S]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::vector<GameResult> reference;
+    double baseline = 0.0;
+    bool consistent = true;
+    std::cout << games << " games of up to " << levels << " levels\n";
+    for (int threads : threadCounts) {
+        std::vector<GameResult> results(games);
+        double seconds = PlayAll(threads, levels, seed, results);
+        long long ticks = 0;
+        for (const GameResult& result : results) {
+            ticks += result.ticks;
+        }
+        if (reference.empty()) {
+            reference = results;
+            baseline = seconds;
+        }
+        int mismatches = 0;
+        for (int game = 0; game < games; game++) {
+            if (results[game].score != reference[game].score 
+                    || results[game].ticks != reference[game].ticks) {
+                mismatches++;
+            }
+        }
+        consistent = consistent && mismatches == 0;
+        std::cout << "threads " << std::setw(3) << threads
+                  << std::fixed << std::setprecision(1)
+                  << "  games/s " << std::setw(8) << games / seconds
+                  << "  ticks/s " << std::setw(10) << ticks / seconds
+                  << std::setprecision(2)
+                  << "  speedup " << baseline / seconds << "x"
+                  << (mismatches == 0 ? "" : "  MISMATCH") << std::endl;
+    }
+    if (!consistent) {
+        std::cout << "games played differently across thread counts" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,167 @@
+// Sweeps the live object count of a headless GameWorld in stress mode and
+// reports the mean and p95 tick time at every population, so scaling
+// regressions show up long before normal play reaches them.
+//
+// Usage: DawnbreakerStress [--max-objects N] [--ticks N] [--csv file]
+//                          [--fixture-dir dir] [--perf-counters]
+//
+// With --fixture-dir every warmed-up world is saved as a snapshot and later
+// runs restore it instead of simulating the warm-up again. With
+// --perf-counters the measured ticks of every population are also broken
+// down into IPC and cache and branch misses per phase.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GameWorld.h"
+#include "PerfCounters.h"
+
+struct SweepResult {
+    int target;
+    int population;
+    double meanMs;
+    double p95Ms;
+};
+
+static SweepResult RunOne(int target, int warmupTicks, int measureTicks, const char* fixtureDir) {
+    // Star particles live for WINDOW_HEIGHT ticks and make up the bulk of the
+    // world, ships and bullets are scaled along so every collision path is
+    // loaded.
+    StressConfig config;
+    config.enabled = true;
+    config.starsPerTick = std::max(1, target / WINDOW_HEIGHT);
+    config.shipCap = std::max(3, target / 100);
+    config.fireInterval = 2;
+    config.autoFire = true;
+    config.enemyFireInterval = 20;
+
+    GameWorld world;
+    world.SetStressConfig(config);
+
+    Snapshot fixture;
+    std::string fixturePath;
+    if (fixtureDir != nullptr) {
+        fixturePath = std::string(fixtureDir) + "/stress-" + std::to_string(target) + ".snap";
+    }
+    if (fixturePath.empty() || !ReadSnapshotFile(fixturePath, fixture) 
+            || !world.RestoreSnapshot(fixture)) {
+        world.Init();
+        for (int i = 0; i < warmupTicks; i++) {
+            world.Update();
+        }
+        if (!fixturePath.empty()) {
+            world.SaveSnapshot(fixture);
+            WriteSnapshotFile(fixturePath, fixture);
+        }
+    }
+
+    PerfCounters::Instance().Reset();
+    std::vector<double> samples;
+    samples.reserve(measureTicks);
+    size_t population = 0;
+    for (int i = 0; i < measureTicks; i++) {
+        auto begin = std::chrono::steady_clock::now();
+        world.Update();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+        population += world.GetObjects().size() + world.GetParticles().GetCount() + 1;
+    }
+    world.CleanUp();
+
+    double sum = 0.0;
+    for (double s : samples) {
+        sum += s;
+    }
+    std::sort(samples.begin(), samples.end());
+    SweepResult result;
+    result.target = target;
+    result.population = static_cast<int>(population / measureTicks);
+    result.meanMs = sum / measureTicks;
+    result.p95Ms = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+    return result;
+}
+
+int main(int argc, char** argv) {
+    int maxObjects = 100000;
+    int measureTicks = 200;
+    const char* csvPath = nullptr;
+    const char* fixtureDir = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-objects") == 0 && i + 1 < argc) {
+            maxObjects = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            measureTicks = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (strcmp(argv[i], "--fixture-dir") == 0 && i + 1 < argc) {
+            fixtureDir = argv[++i];
+        } else if (strcmp(argv[i], "--perf-counters") == 0) {
+            PerfCounters::Instance().Enable();
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--max-objects N] [--ticks N] [--csv file]"
+                      << " [--fixture-dir dir] [--perf-counters]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << "object sizes (bytes, objects per 64-byte cache line)\n";
+    for (int type = 0; type < GameObject::TYPE_COUNT; type++) {
+        size_t size = GameObject::SizeOf(static_cast<GameObject::ObjectType>(type));
+        std::cout << "  " << std::left << std::setw(14) 
+                  << GameObject::TypeName(static_cast<GameObject::ObjectType>(type)) << std::right 
+                  << std::setw(4) << size << "  " << std::fixed << std::setprecision(2) 
+                  << 64.0 / size << "\n";
+    }
+    std::cout << std::endl;
+
+    std::vector<SweepResult> results;
+    const int targets[] = { 1000, 2000, 5000, 10000, 20000, 50000, 100000 };
+    for (int target : targets) {
+        if (target > maxObjects) {
+            break;
+        }
+        // Let the starfield fill the whole screen before measuring.
+        SweepResult result = RunOne(target, WINDOW_HEIGHT + 100, measureTicks, fixtureDir);
+        std::cout << "target " << std::setw(6) << result.target
+                  << "  live " << std::setw(6) << result.population
+                  << "  mean " << std::fixed << std::setprecision(3) << result.meanMs << " ms"
+                  << "  p95 " << result.p95Ms << " ms" << std::endl;
+        PerfCounters::Instance().Report(std::cout);
+        results.push_back(result);
+    }
+
+    if (results.empty()) {
+        return EXIT_SUCCESS;
+    }
+
+    // Tick time against live objects, one bar per sweep point.
+    double worst = 0.0;
+    for (auto& result : results) {
+        worst = std::max(worst, result.meanMs);
+    }
+    std::cout << "\nmean tick time vs. live objects\n";
+    for (auto& result : results) {
+        int width = worst > 0.0 ? static_cast<int>(60.0 * result.meanMs / worst + 0.5) : 0;
+        std::cout << std::setw(7) << result.population << " | "
+                  << std::string(std::max(width, 1), '#') << " "
+                  << std::setprecision(3) << result.meanMs << " ms\n";
+    }
+
+    if (csvPath != nullptr) {
+        std::ofstream csv(csvPath);
+        csv << "target,live_objects,mean_ms,p95_ms\n";
+        for (auto& result : results) {
+            csv << result.target << "," << result.population << ","
+                << result.meanMs << "," << result.p95Ms << "\n";
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+// Converts a telemetry file written with --telemetry (by the game or
+// DawnbreakerAutopilot) into CSV, one row per record, for spreadsheets and
+// pandas.
+//
+// Usage: DawnbreakerTelemetry file [--csv out] [--kind name]
+//
+// Without --csv the rows go to standard output. --kind keeps only records of
+// one kind, e.g. "frame" or "damage". Rows are sorted by time, so the
+// sources (threads) are merged back into one timeline. subject_name and
+// value1_name spell out object types and level statuses where those columns
+// hold them.
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "GameObjects.h"
+#include "Telemetry.h"
+
+static const char* TypeName(int type) {
+    if (type < 0 || type >= GameObject::TYPE_COUNT) {
+        return "";
+    }
+    return GameObject::TypeName(static_cast<GameObject::ObjectType>(type));
+}
+
+static const char* StatusName(int status) {
+    switch (static_cast<LevelStatus>(status)) {
+    case LevelStatus::ONGOING:
+        return "ongoing";
+    case LevelStatus::DAWNBREAKER_DESTROYED:
+        return "dawnbreaker_destroyed";
+    case LevelStatus::LEVEL_CLEARED:
+        return "level_cleared";
+    }
+    return "";
+}
+
+int main(int argc, char** argv) {
+    const char* inPath = nullptr;
+    const char* csvPath = nullptr;
+    const char* kindName = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (strcmp(argv[i], "--kind") == 0 && i + 1 < argc) {
+            kindName = argv[++i];
+        } else if (argv[i][0] != '-' && inPath == nullptr) {
+            inPath = argv[i];
+        } else {
+            inPath = nullptr;
+            break;
+        }
+    }
+    if (inPath == nullptr) {
+        std::cerr << "Usage: " << argv[0] << " file [--csv out] [--kind name]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream in(inPath, std::ios::binary);
+    std::vector<Telemetry::Record> records;
+    if (!in || !Telemetry::Read(in, records)) {
+        std::cerr << "'" << inPath << "' is not a telemetry file" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::stable_sort(records.begin(), records.end(),
+        [](const Telemetry::Record& a, const Telemetry::Record& b) { return a.ns < b.ns; });
+
+    std::ofstream file;
+    if (csvPath != nullptr) {
+        file.open(csvPath);
+        if (!file) {
+            std::cerr << "Cannot write '" << csvPath << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    std::ostream& out = csvPath != nullptr ? file : std::cout;
+    out << "ns,source,tick,kind,subject,subject_name,value0,value1,value1_name\n";
+    for (const auto& record : records) {
+        Telemetry::Kind kind = static_cast<Telemetry::Kind>(record.kind);
+        if (kindName != nullptr && strcmp(kindName, Telemetry::KindName(kind)) != 0) {
+            continue;
+        }
+        const char* subjectName = "";
+        const char* value1Name = "";
+        switch (kind) {
+        case Telemetry::Kind::DAMAGE:
+            value1Name = TypeName(record.value1);
+            subjectName = TypeName(record.subject);
+            break;
+        case Telemetry::Kind::OBJECTS:
+        case Telemetry::Kind::KILL:
+        case Telemetry::Kind::PICKUP:
+            subjectName = TypeName(record.subject);
+            break;
+        case Telemetry::Kind::LEVEL_END:
+            value1Name = StatusName(record.value1);
+            break;
+        default:
+            break;
+        }
+        out << record.ns << "," << static_cast<int>(record.source) << "," << record.tick << ","
+            << Telemetry::KindName(kind) << "," << record.subject << "," << subjectName << ","
+            << record.value0 << "," << record.value1 << "," << value1Name << "\n";
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+// Plays a versus match headless, with the Autopilot on this side, against a
+// second DawnbreakerVersus process on the same machine. Start one with
+// --host and one with --join; the latency shim on each side delays, jitters
+// and drops its outgoing datagrams to exercise the rollback.
+//
+// Usage: DawnbreakerVersus (--host | --join) [--port N] [--levels N]
+//                          [--fps N] [--delay ms] [--jitter ms] [--loss %]
+//
+// At the end both sides print the hash of the final state of both worlds;
+// equal hashes mean the two simulations stayed identical.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "Autopilot.h"
+#include "VersusWorld.h"
+
+int main(int argc, char** argv) {
+    int role = -1;
+    int port = 47800;
+    int levels = 3;
+    int fps = 60;
+    int delay = 0;
+    int jitter = 0;
+    int loss = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--host") == 0) {
+            role = 0;
+        } else if (strcmp(argv[i], "--join") == 0) {
+            role = 1;
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--levels") == 0 && i + 1 < argc) {
+            levels = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            fps = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--delay") == 0 && i + 1 < argc) {
+            delay = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--jitter") == 0 && i + 1 < argc) {
+            jitter = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+            loss = atoi(argv[++i]);
+        } else {
+            role = -1;
+            break;
+        }
+    }
+    if (role < 0) {
+        std::cerr << "Usage: " << argv[0] << " (--host | --join) [--port N] [--levels N]"
+                  << " [--fps N] [--delay ms] [--jitter ms] [--loss %]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    VersusWorld world(role == 0 ? VersusWorld::Role::HOST : VersusWorld::Role::GUEST);
+    Autopilot bot(world);
+    world.SetLocalInput(&bot);
+    world.SetPort(static_cast<unsigned short>(port));
+    world.SetTargetLevel(levels);
+    world.SetImpairment(delay, jitter, loss);
+    world.Init();
+
+    // Frames are paced like the game's timer; the slowest update is the
+    // cost of the deepest rollback.
+    auto frameTime = std::chrono::microseconds(1000000 / fps);
+    auto next = std::chrono::steady_clock::now();
+    double worstMs = 0.0;
+    double totalMs = 0.0;
+    long long updates = 0;
+    while (true) {
+        auto begin = std::chrono::steady_clock::now();
+        LevelStatus status = world.Update();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        if (status != LevelStatus::ONGOING) {
+            break;
+        }
+        worstMs = std::max(worstMs, ms);
+        totalMs += ms;
+        updates++;
+        next += frameTime;
+        std::this_thread::sleep_until(next);
+    }
+
+    const VersusWorld::Stats& stats = world.GetStats();
+    std::cout << "frames " << stats.frames
+              << "  stalls " << stats.stalls
+              << "  rollbacks " << stats.rollbacks
+              << "  resimulated " << stats.resimulated
+              << "  deepest " << stats.maxDepth << std::endl;
+    std::cout << std::fixed << std::setprecision(3)
+              << "update mean " << (updates > 0 ? totalMs / updates : 0.0) << " ms"
+              << "  worst " << worstMs << " ms" << std::endl;
+    std::cout << "level " << world.GetLevel() << " score " << world.GetScore()
+              << "  rival level " << world.GetRival().GetLevel() << " score " << world.GetRival().GetScore() 
+              << std::endl;
+    std::cout << "final state " << std::hex << world.Checksum() << std::dec
+              << (stats.desync ? "  DESYNC" : "") << std::endl;
+    return stats.desync || world.GetOutcome() == VersusWorld::Outcome::ABANDONED ? EXIT_FAILURE : EXIT_SUCCESS;
+}
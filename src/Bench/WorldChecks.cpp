@@ -0,0 +1,120 @@
+// Headless checks of GameWorld bookkeeping that normal play rarely hits.
+// Prints one line per check and exits non-zero if any of them fails; CTest
+// runs it as WorldChecks.
+//
+// Usage: DawnbreakerChecks
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "Autopilot.h"
+#include "GameObjects.h"
+#include "GameWorld.h"
+#include "VersusWorld.h"
+
+// Holds FIRE1 and nothing else.
+class FireInput : public InputSource {
+public:
+    bool GetKey(KeyCode key) const override { return key == KeyCode::FIRE1; }
+    bool GetKeyDown(KeyCode) override { return false; }
+};
+
+static int failures = 0;
+
+static void Check(bool ok, const std::string& what) {
+    std::cout << (ok ? "ok     " : "FAILED ") << what << std::endl;
+    if (!ok) {
+        failures++;
+    }
+}
+
+static int CountType(GameWorld& world, GameObject::ObjectType type) {
+    int count = 0;
+    for (auto& obj : world.GetObjects()) {
+        if (obj->GetType() == type) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static bool NoDeadObjects(GameWorld& world) {
+    for (auto& obj : world.GetObjects()) {
+        if (obj->GetIsDead()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A bullet the player fires into a ship right in front of it is spawned,
+// hits and dies within one tick, and is gone from the store after it.
+static void BulletSpawnsAndDiesInOneTick() {
+    GameWorld world;
+    FireInput input;
+    world.SetInputSource(&input);
+    world.Init();
+    int x = world.m_player->GetX();
+    int y = world.m_player->GetY();
+    {
+        WorldBase::Scope scope(world);
+        world.AddObject(std::make_unique<AlphaShip>(x, y + 60, 180, 1.0, 1000000, 0, 0));
+    }
+    int fired = 0;
+    int dead = 0;
+    for (int tick = 0; tick < 60 && world.Update() == LevelStatus::ONGOING; tick++) {
+        fired += world.m_player->GetEnergy() < world.m_player->GetMaxEnergy() ? 1 : 0;
+        dead += NoDeadObjects(world) ? 0 : 1;
+    }
+    Check(fired > 0, "the player fired into the ship");
+    Check(dead == 0, "bullets that spawned and died in one tick left the store");
+    Check(CountType(world, GameObject::ObjectType::TypeBlueBullet) == 0, "no bullet got past the ship");
+}
+
+// An object that dies while it still waits to join the store is removed
+// with the rest at the end of the tick.
+static void ObjectDiesBeforeJoiningTheStore() {
+    GameWorld world;
+    world.Init();
+    {
+        WorldBase::Scope scope(world);
+        std::unique_ptr<GameObject> bullet = std::make_unique<BlueBullet>(100, 100, 0, 0.5, 5);
+        GameObject* pending = bullet.get();
+        world.AddObject(std::move(bullet));
+        pending->SetIsDead();
+    }
+    world.Update();
+    Check(NoDeadObjects(world), "an object dead before joining the store was compacted");
+    Check(CountType(world, GameObject::ObjectType::TypeBlueBullet) == 0, "the dead bullet did not stay in the store");
+}
+
+// GameManager sleeps through prompts until a key event, which a bot never
+// sends, so a world played by the autopilot has to be polled, and the bot
+// has to answer the prompts between levels.
+static void AutopilotIsPolledAtPrompts() {
+    GameWorld world;
+    Autopilot bot(world);
+    world.SetInputSource(&bot);
+    world.Init();
+    Check(!world.GetInputSource()->IsInteractive(), "prompts poll the autopilot");
+    Check(world.GetKey(KeyCode::ENTER), "the autopilot answers the prompts between levels");
+    world.SetLives(0);
+    Check(!world.GetKey(KeyCode::ENTER), "the autopilot leaves the game over prompt alone");
+
+    VersusWorld versus(VersusWorld::Role::HOST);
+    Autopilot rivalBot(versus);
+    versus.SetLocalInput(&rivalBot);
+    Check(!versus.GetInputSource()->IsInteractive(), "prompts poll the autopilot in versus mode");
+}
+
+int main() {
+    BulletSpawnsAndDiesInOneTick();
+    ObjectDiesBeforeJoiningTheStore();
+    AutopilotIsPolledAtPrompts();
+    if (failures > 0) {
+        std::cout << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
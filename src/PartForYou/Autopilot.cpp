@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Autopilot.h"
+#include "GameWorld.h"
+
+namespace {
+
+// A moving thing the Dawnbreaker must not touch, with its velocity per tick.
+struct Threat {
+    double x, y;
+    double vx, vy;
+    double radius;
+};
+
+// Velocity of a ship or bullet heading 180 (down), 162 (down right) or
+// 198 (down left) with the given vertical and horizontal speed.
+void Heading(int direction, double down, double side, double& vx, double& vy) {
+    vy = -down;
+    vx = direction == 162 ? side : direction == 198 ? -side : 0;
+}
+
+}
+
+Autopilot::Autopilot(GameWorld& world): 
+    m_world(world), m_keys(), m_thoughtPlayer(nullptr), m_thoughtTick(-1), 
+    m_meteorPending(false), m_quitAtGameOver(false) { }
+
+bool Autopilot::GetKey(KeyCode key) const {
+    if (key == KeyCode::ENTER) {
+        return !this->m_world.IsGameOver() || this->m_quitAtGameOver;
+    }
+    this->Think();
+    return this->m_keys[static_cast<int>(key)];
+}
+
+bool Autopilot::GetKeyDown(KeyCode key) {
+    bool pressed = this->GetKey(key);
+    if (key == KeyCode::FIRE2) {
+        pressed = pressed && this->m_meteorPending;
+        this->m_meteorPending = false;
+    }
+    return pressed;
+}
+
+void Autopilot::SetQuitAtGameOver(bool quit) {
+    this->m_quitAtGameOver = quit;
+}
+
+void Autopilot::Think() const {
+    const Player* player = this->m_world.m_player.get();
+    if (player == this->m_thoughtPlayer && this->m_world.GetTick() == this->m_thoughtTick) {
+        return;
+    }
+    this->m_thoughtPlayer = player;
+    this->m_thoughtTick = this->m_world.GetTick();
+    this->m_keys.fill(false);
+    this->m_meteorPending = false;
+    if (player == nullptr || player->GetIsDead()) {
+        return;
+    }
+
+    const double px = player->GetX();
+    const double py = player->GetY();
+    const double playerRadius = player->GetRadius();
+
+    // Gather what can hit us, the lowest goodie and the enemy to line up
+    // with: the lowest ship above the Dawnbreaker, led by its sideways drift.
+    std::vector<Threat> threats;
+    bool haveTarget = false;
+    double targetX = px;
+    double targetY = 0;
+    int crowd = 0;
+    bool inReach = false;
+    bool haveSnack = false;
+    double snackX = 0, snackY = 0;
+    // What the Dawnbreaker fires, as in Player::Update.
+    const GameObject::Archetype& blueBullet = GameObject::GetArchetype(GameObject::TypeBlueBullet);
+    const double bulletRadius = blueBullet.radiusFactor * (0.5 + 0.1 * player->GetUpgrade());
+    const double redBulletSpeed = GameObject::GetArchetype(GameObject::TypeRedBullet).speed;
+    for (auto& obj : this->m_world.GetObjects()) {
+        if (obj->GetIsDead() || std::abs(obj->GetY() - py) > 400) {
+            continue;
+        }
+        GameObject::ObjectType type = obj->GetType();
+        if (type == GameObject::TypeRedBullet) {
+            Threat t{ double(obj->GetX()), double(obj->GetY()), 0, 0, obj->GetRadius() };
+            Heading(obj->GetDirection(), redBulletSpeed, 2, t.vx, t.vy);
+            threats.push_back(t);
+        } else if (type == GameObject::TypeHealthWidget || type == GameObject::TypeUpgradeWidget 
+                || type == GameObject::TypeMeteorWidget) {
+            if (obj->GetY() < py + 300 && (!haveSnack || obj->GetY() < snackY)) {
+                haveSnack = true;
+                snackX = obj->GetX();
+                snackY = obj->GetY();
+            }
+        } else if (type == GameObject::TypeAlphaShip || type == GameObject::TypeSigmaShip 
+                || type == GameObject::TypeOmegaShip) {
+            const EnemyShip& ship = static_cast<const EnemyShip&>(*obj);
+            Threat t{ double(ship.GetX()), double(ship.GetY()), 0, 0, ship.GetRadius() };
+            Heading(ship.GetStrategy(), ship.GetSpeed(), ship.GetSpeed(), t.vx, t.vy);
+            if (type == GameObject::TypeSigmaShip) {
+                t.vy = -10; // dives as soon as we pass beneath it
+            }
+            threats.push_back(t);
+            if (t.y > py + 50 && std::abs(t.x - px) < t.radius + bulletRadius) {
+                inReach = true;
+            }
+            if (t.y > py + 50) {
+                if (t.y - py < 300) {
+                    crowd++;
+                }
+                if (!haveTarget || t.y < targetY) {
+                    // A blue bullet climbs while the ship closes in.
+                    double ticks = (t.y - py - 50) / (blueBullet.speed - t.vy);
+                    haveTarget = true;
+                    targetY = t.y;
+                    targetX = t.x + t.vx * ticks;
+                }
+            }
+        }
+    }
+
+    // Alpha ships only shoot and Sigma ships only dive at a Dawnbreaker
+    // within ten pixels, while a blue bullet hits anywhere within 45: line
+    // up beside the target instead of beneath it.
+    if (haveTarget) {
+        targetX += px < targetX ? -AIM_OFFSET : AIM_OFFSET;
+    }
+    if (haveSnack) {
+        targetX = snackX; // goodies first, they heal and upgrade
+    }
+
+    // Try every move held over the look-ahead. A move is ranked by how long
+    // it stays clear of every threat, then by its clearance up to a safe
+    // margin, then by how close it brings us to the target and home row.
+    const double homeY = 150;
+    int bestDx = 0, bestDy = 0;
+    int bestClearTicks = -1;
+    double bestClearance = -1e9, bestCost = 1e9;
+    for (int dx = -4; dx <= 4; dx += 4) {
+        for (int dy = -4; dy <= 4; dy += 4) {
+            if ((dx < 0 && px < 4) || (dx > 0 && px > WINDOW_WIDTH - 5) 
+                    || (dy < 0 && py < 54) || (dy > 0 && py > WINDOW_HEIGHT - 5)) {
+                continue;
+            }
+            int clearTicks = HORIZON;
+            double clearance = SAFE_CLEARANCE;
+            for (int k = 1; k <= HORIZON && clearTicks == HORIZON; k++) {
+                double x = std::min(std::max(px + dx * k, 0.0), double(WINDOW_WIDTH - 1));
+                double y = std::min(std::max(py + dy * k, 50.0), double(WINDOW_HEIGHT - 1));
+                for (const Threat& t : threats) {
+                    double gap = std::hypot(t.x + t.vx * k - x, t.y + t.vy * k - y) 
+                        - t.radius - playerRadius;
+                    clearance = std::min(clearance, gap);
+                    if (gap < 0) {
+                        clearTicks = k - 1;
+                    }
+                }
+            }
+            double cost = std::abs(px + dx - targetX) + 0.5 * std::abs(py + dy - homeY);
+            bool better = clearTicks != bestClearTicks ? clearTicks > bestClearTicks 
+                : clearance != bestClearance ? clearance > bestClearance 
+                : cost < bestCost;
+            if (better) {
+                bestDx = dx;
+                bestDy = dy;
+                bestClearTicks = clearTicks;
+                bestClearance = clearance;
+                bestCost = cost;
+            }
+        }
+    }
+    this->m_keys[static_cast<int>(KeyCode::LEFT)] = bestDx < 0;
+    this->m_keys[static_cast<int>(KeyCode::RIGHT)] = bestDx > 0;
+    this->m_keys[static_cast<int>(KeyCode::DOWN)] = bestDy < 0;
+    this->m_keys[static_cast<int>(KeyCode::UP)] = bestDy > 0;
+
+    // Fire whenever a ship is in reach, and spend a meteor when crowded or
+    // hurt.
+    this->m_keys[static_cast<int>(KeyCode::FIRE1)] = inReach;
+    if (player->GetMeteor() > 0 && haveTarget 
+            && (crowd >= 3 || player->GetHealth() <= 30)) {
+        this->m_keys[static_cast<int>(KeyCode::FIRE2)] = true;
+        this->m_meteorPending = true;
+    }
+}
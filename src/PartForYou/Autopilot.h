@@ -0,0 +1,51 @@
+#ifndef AUTOPILOT_H__
+#define AUTOPILOT_H__
+
+#include <array>
+
+#include "InputSource.h"
+
+class GameWorld;
+
+// A bot that plays the Dawnbreaker. Once per tick, on the first key query,
+// it looks at the live world: it dodges red bullets and ships on a short
+// linear look-ahead, lines up beside the nearest enemy, fires when it is
+// in reach and drops a meteor when crowded or hurt. It answers the prompts
+// between levels with Enter so it can play unattended, but leaves the game
+// over prompt to the player unless told to quit there.
+class Autopilot : public InputSource {
+
+public:
+
+    explicit Autopilot(GameWorld&);
+    virtual ~Autopilot() = default;
+
+    bool GetKey(KeyCode) const override;
+    bool GetKeyDown(KeyCode) override;
+
+    // Whether Enter is also held once the game is over, which quits it.
+    void SetQuitAtGameOver(bool);
+
+private:
+
+    static const int KEY_COUNT = static_cast<int>(KeyCode::QUIT) + 1;
+
+    // Ticks of look-ahead when dodging.
+    static const int HORIZON = 20;
+    // Clearance in pixels that counts as safe.
+    static const int SAFE_CLEARANCE = 24;
+    // Horizontal distance kept from the enemy being shot at.
+    static const int AIM_OFFSET = 25;
+
+    void Think() const;
+
+    GameWorld& m_world;
+    mutable std::array<bool, KEY_COUNT> m_keys;
+    mutable const void* m_thoughtPlayer;
+    mutable int m_thoughtTick;
+    mutable bool m_meteorPending;
+    bool m_quitAtGameOver;
+
+};
+
+#endif // !AUTOPILOT_H__
@@ -0,0 +1,111 @@
+#include "FrameGovernor.h"
+
+#include <iomanip>
+#include <iostream>
+
+#include "Telemetry.h"
+#include "TraceRecorder.h"
+
+FrameGovernor::FrameGovernor():
+    m_budgetMs(0.0), m_tickStart(), m_averageMs(0.0), m_level(0), m_ticksSinceTransition(0),
+    m_headroomTicks(0), m_transitions(0), m_ticksAtLevel() { }
+
+void FrameGovernor::SetBudget(double ms) {
+    this->m_budgetMs = ms > 0.0 ? ms : 0.0;
+    this->m_averageMs = 0.0;
+    this->m_level = 0;
+    this->m_ticksSinceTransition = 0;
+    this->m_headroomTicks = 0;
+}
+
+double FrameGovernor::GetBudget() const {
+    return this->m_budgetMs;
+}
+
+bool FrameGovernor::IsEnabled() const {
+    return this->m_budgetMs > 0.0;
+}
+
+void FrameGovernor::BeginTick() {
+    if (this->IsEnabled()) {
+        this->m_tickStart = Clock::now();
+    }
+}
+
+bool FrameGovernor::EndTick(int tick) {
+    if (!this->IsEnabled()) {
+        return false;
+    }
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - this->m_tickStart).count();
+    this->m_averageMs += SMOOTHING * (ms - this->m_averageMs);
+    this->m_ticksAtLevel[this->m_level]++;
+    this->m_ticksSinceTransition++;
+
+    if (this->m_averageMs > this->m_budgetMs) {
+        this->m_headroomTicks = 0;
+        if (this->m_level < static_cast<int>(Step::COUNT)
+                && this->m_ticksSinceTransition >= ESCALATE_TICKS) {
+            this->Transition(this->m_level + 1, tick);
+            return true;
+        }
+        return false;
+    }
+    if (this->m_averageMs < RELAX_FRACTION * this->m_budgetMs) {
+        this->m_headroomTicks++;
+    } else {
+        this->m_headroomTicks = 0;
+    }
+    if (this->m_level > 0 && this->m_headroomTicks >= RELAX_TICKS) {
+        this->Transition(this->m_level - 1, tick);
+        return true;
+    }
+    return false;
+}
+
+void FrameGovernor::Transition(int level, int tick) {
+    bool up = level > this->m_level;
+    // Turned on when going up, off when going down
+    Step step = static_cast<Step>(up ? level - 1 : this->m_level - 1);
+    std::cerr << "governor: tick " << tick << ", " << std::fixed << std::setprecision(3)
+              << this->m_averageMs << " ms a tick against " << this->m_budgetMs << " ms, "
+              << (up ? "on: " : "off: ") << StepName(step) << " (level " << level << ")" << std::endl;
+    TraceRecorder::Instance().Instant("governor", up ? "step on" : "step off", StepName(step));
+    Telemetry::Instance().Emit(Telemetry::Kind::GOVERNOR, tick, level,
+        static_cast<int>(this->m_averageMs * 1000), static_cast<int>(this->m_budgetMs * 1000));
+
+    this->m_level = level;
+    this->m_ticksSinceTransition = 0;
+    this->m_headroomTicks = 0;
+    this->m_transitions++;
+}
+
+int FrameGovernor::GetLevel() const {
+    return this->m_level;
+}
+
+bool FrameGovernor::IsOn(Step step) const {
+    return this->m_level > static_cast<int>(step);
+}
+
+const char* FrameGovernor::StepName(Step step) {
+    switch (step) {
+    case Step::FEWER_STARS:
+        return "fewer stars";
+    case Step::SHORT_EXPLOSIONS:
+        return "short explosions";
+    case Step::PARTICLE_CAP:
+        return "particle cap";
+    case Step::LAZY_STATUS_BAR:
+        return "lazy status bar";
+    default:
+        return "unknown";
+    }
+}
+
+void FrameGovernor::Print(std::ostream& out) const {
+    out << "governor: " << this->m_transitions << " transitions, ticks at level";
+    for (int level = 0; level <= static_cast<int>(Step::COUNT); level++) {
+        out << " " << level << ": " << this->m_ticksAtLevel[level];
+    }
+    out << std::endl;
+}
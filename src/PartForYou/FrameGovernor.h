@@ -0,0 +1,78 @@
+#ifndef FRAMEGOVERNOR_H__
+#define FRAMEGOVERNOR_H__
+
+#include <chrono>
+#include <ostream>
+
+// Keeps GameWorld::Update() within a time budget. The world reports every
+// ongoing tick; while the average overruns the budget, the governor turns on
+// one more Step every ESCALATE_TICKS, and once the average has stayed below
+// RELAX_FRACTION of the budget for RELAX_TICKS it turns the latest one off
+// again. Every transition is logged to stderr, the trace and the telemetry.
+//
+// Steps only give up cosmetic work, and the world still draws the same
+// random numbers with them on, so play goes on exactly as it would have.
+class FrameGovernor {
+
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    // In the order they are turned on.
+    enum class Step {
+        FEWER_STARS,        // one star spawn in STAR_DIVISOR
+        SHORT_EXPLOSIONS,   // explosions last SHORT_EXPLOSION_TICKS
+        PARTICLE_CAP,       // no particle spawns beyond PARTICLE_CAP
+        LAZY_STATUS_BAR,    // the status bar is formatted every STATUS_BAR_TICKS
+        COUNT
+    };
+
+    static const int STAR_DIVISOR = 4;
+    static const int SHORT_EXPLOSION_TICKS = 8;
+    static const int PARTICLE_CAP = 512;
+    static const int STATUS_BAR_TICKS = 15;
+
+    // A quarter of a second between steps up, two seconds of headroom
+    // before a step down, so one slow tick does not make the picture flicker.
+    static const int ESCALATE_TICKS = 15;
+    static const int RELAX_TICKS = 120;
+    static constexpr double RELAX_FRACTION = 0.5;
+    // Weight of the newest tick in the average.
+    static constexpr double SMOOTHING = 1.0 / 8;
+
+    FrameGovernor();
+
+    // 0 turns the governor off along with every step.
+    void SetBudget(double ms);
+    double GetBudget() const;
+    bool IsEnabled() const;
+
+    void BeginTick();
+    // Ends a tick begun with BeginTick(); ticks that end the level are left
+    // out. Returns whether a step was turned on or off.
+    bool EndTick(int tick);
+
+    // Steps turned on.
+    int GetLevel() const;
+    bool IsOn(Step step) const;
+    static const char* StepName(Step step);
+
+    // Transitions so far and ticks spent at each level.
+    void Print(std::ostream& out) const;
+
+private:
+
+    void Transition(int level, int tick);
+
+    double m_budgetMs;
+    Clock::time_point m_tickStart;
+    double m_averageMs;
+    int m_level;
+    int m_ticksSinceTransition;
+    int m_headroomTicks;
+    long long m_transitions;
+    long long m_ticksAtLevel[static_cast<int>(Step::COUNT) + 1];
+
+};
+
+#endif // !FRAMEGOVERNOR_H__
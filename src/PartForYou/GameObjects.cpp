@@ -1,22 +1,41 @@
 #include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <iostream>
 
 #include "GameObjects.h"
+#include "ObjectPool.h"
+#include "Telemetry.h"
+
+// Layout budget (64-bit): ObjectBase packs into 24 bytes with the vtable
+// pointer, GameObject's hot fields end at byte 32, and every object but the
+// player fits the 48-byte ObjectPool size class, i.e. four objects per three
+// cache lines.
+static_assert(sizeof(void*) != 8 || sizeof(ObjectBase) == 24, "ObjectBase outgrew 24 bytes");
+static_assert(sizeof(void*) != 8 || sizeof(GameObject) == 48, "GameObject outgrew 48 bytes");
+static_assert(sizeof(BlueBullet) <= sizeof(GameObject), "BlueBullet must not add fields");
+static_assert(sizeof(RedBullet) <= sizeof(GameObject), "RedBullet must not add fields");
+static_assert(sizeof(Meteor) <= sizeof(GameObject), "Meteor must not add fields");
+static_assert(sizeof(AlphaShip) <= sizeof(GameObject), "EnemyShip must fit GameObject's tail padding");
+static_assert(sizeof(SigmaShip) <= sizeof(GameObject), "EnemyShip must fit GameObject's tail padding");
+static_assert(sizeof(OmegaShip) <= sizeof(GameObject), "EnemyShip must fit GameObject's tail padding");
+static_assert(sizeof(HealthWidget) <= sizeof(GameObject), "widgets must not add fields");
+static_assert(sizeof(Player) <= 64, "Player must fit one cache line");
+
 
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////Utilities///////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 
+static void RecordDamage(const GameObject& target, int damage, GameObject::ObjectType by) {
+    Telemetry::Instance().Emit(Telemetry::Kind::DAMAGE, target.GetGameWorld().GetTick(), 
+        target.GetType(), damage, by);
+}
+
 static void Destroy(std::unique_ptr<GameObject>& target) {
-    target->GetGameWorld().AddObject(
-        std::make_unique<Explosion>(
-            IMGID_EXPLOSION, // image id
-            target->GetX(), target->GetY(), // x, y
-            0, // direction
-            3, // layer
-            4.5, // size
-            target->GetGameWorld() // game world
-        )
-    );               
+    Telemetry::Instance().Emit(Telemetry::Kind::KILL, target->GetGameWorld().GetTick(), 
+        target->GetType(), target->GetScore());
+    target->GetGameWorld().GetParticles().SpawnExplosion(target->GetX(), target->GetY());
     target->GetGameWorld().m_player->SetDestroyed(
         target->GetGameWorld().m_player->GetDestroyed() + 1
     );
@@ -30,23 +49,77 @@ static void Destroy(std::unique_ptr<GameObject>&& target) {
     target.release();
 }
 
+// Indexed by ObjectType.
+static constexpr GameObject::Archetype ARCHETYPES[GameObject::TYPE_COUNT] = {
+    // imageID, layer, speed, score, maxEnergy, radiusFactor
+    { IMGID_DAWNBREAKER, 0, 4, 0, 10, 30.0f }, // Player
+    { IMGID_METEOR, 1, 2, 0, 0, 30.0f }, // Meteor
+    { IMGID_BLUE_BULLET, 1, 6, 0, 0, 30.0f }, // BlueBullet
+    { IMGID_RED_BULLET, 1, 6, 0, 0, 30.0f }, // RedBullet
+    { IMGID_ALPHATRON, 0, 2, 50, 25, 30.0f }, // AlphaShip
+    { IMGID_SIGMATRON, 0, 2, 100, 0, 30.0f }, // SigmaShip
+    { IMGID_OMEGATRON, 0, 3, 200, 50, 30.0f }, // OmegaShip
+    { IMGID_HP_RESTORE_GOODIE, 2, 2, 20, 0, 30.0f }, // HealthWidget
+    { IMGID_POWERUP_GOODIE, 2, 2, 20, 0, 30.0f }, // UpgradeWidget
+    { IMGID_METEOR_GOODIE, 2, 2, 20, 0, 30.0f } // MeteorWidget
+};
+static_assert(sizeof(ARCHETYPES) <= 128, "archetypes should fit two cache lines");
+
+static int TypeMemTag(GameObject::ObjectType type) {
+    static const std::array<int, GameObject::TYPE_COUNT> tags = [] {
+        std::array<int, GameObject::TYPE_COUNT> ids;
+        for (int i = 0; i < GameObject::TYPE_COUNT; i++) {
+            // Objects live in "object pool" chunks, so they stay out of the totals
+            ids[i] = MemoryTracker::Instance().RegisterTag(
+                std::string("objects/") + GameObject::TypeName(static_cast<GameObject::ObjectType>(i)), false);
+        }
+        return ids;
+    }();
+    return tags[type];
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////GameObject//////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-GameObject::GameObject(int imageID, int x, int y, int direction, 
-        int layer, double size, GameWorld& gameWorld, ObjectType type, 
-        int health, int damage, int speed, int energy, int score): 
-    ObjectBase(imageID, x, y, direction, layer, size), 
-    m_gameWorld(gameWorld), m_type(type), m_health(health), 
-    m_damage(damage), m_speed(speed), m_energy(energy), m_score(score) { }
+GameObject::GameObject(ObjectType type, int x, int y, int direction, 
+        double size, int health, int damage): 
+    ObjectBase(ARCHETYPES[type].imageID, x, y, direction, ARCHETYPES[type].layer, size), 
+    m_health(health), m_type(static_cast<uint8_t>(type)), m_queuedDead(false), 
+    m_speed(ARCHETYPES[type].speed), 
+    m_cold{ damage, -1, 0 } { 
+    ObjectPool::Of(this).GetCounts().Allocate(TypeMemTag(type), SizeOf(type));
+}
+
+GameObject::~GameObject() {
+    ObjectPool& pool = ObjectPool::Of(this);
+    pool.GetCounts().Deallocate(TypeMemTag(this->GetType()), SizeOf(this->GetType()));
+    // Leaves the registry of the world that owns the object, whichever world
+    // is current on this thread, if any.
+    this->Unregister(pool.GetWorld().GetContext().registry);
+}
+
+void* GameObject::operator new(std::size_t size) {
+    WorldBase* world = WorldBase::Current();
+    if (world == nullptr || dynamic_cast<GameWorld*>(world) == nullptr) {
+        std::cerr << "GameObject created outside a GameWorld's WorldBase::Scope" << std::endl;
+        std::abort();
+    }
+    return static_cast<GameWorld*>(world)->GetObjectPool().Allocate(size);
+}
+
+void GameObject::operator delete(void* block, std::size_t size) {
+    if (block != nullptr) {
+        ObjectPool::Of(block).Deallocate(block, size);
+    }
+}
 
 GameWorld& GameObject::GetGameWorld() const {
-    return this->m_gameWorld;
+    return ObjectPool::Of(this).GetWorld();
 }
 
 GameObject::ObjectType GameObject::GetType() const {
-    return this->m_type;
+    return static_cast<ObjectType>(this->m_type);
 }
 
 int GameObject::GetHealth() const {
@@ -55,14 +128,17 @@ int GameObject::GetHealth() const {
 
 void GameObject::SetHealth(int health) {
     this->m_health = health;
+    if (this->GetIsDead()) {
+        this->NotifyDead();
+    }
 }
 
 int GameObject::GetDamage() const {
-    return this->m_damage;
+    return this->m_cold.damage;
 }
 
 void GameObject::SetDamage(int damage) {
-    this->m_damage = damage;
+    this->m_cold.damage = damage;
 }
 
 int GameObject::GetSpeed() const {
@@ -70,19 +146,40 @@ int GameObject::GetSpeed() const {
 }
 
 void GameObject::SetSpeed(int speed) {
-    this->m_speed = speed;
+    this->m_speed = static_cast<int16_t>(speed);
 }
 
 int GameObject::GetEnergy() const {
-    return this->m_energy;
+    return this->EnergyAt(this->GetGameWorld().GetTick());
 }
 
 void GameObject::SetEnergy(int energy) {
-    this->m_energy = energy;
+    this->m_cold.energyFull = this->GetGameWorld().GetTick() + this->GetMaxEnergy() - energy;
+}
+
+int GameObject::EnergyAt(int tick) const {
+    int missing = std::min(std::max(this->m_cold.energyFull - tick, 0), this->GetMaxEnergy());
+    return this->GetMaxEnergy() - missing;
+}
+
+int GameObject::GetMaxEnergy() const {
+    return ARCHETYPES[this->m_type].maxEnergy;
 }
 
 int GameObject::GetScore() const {
-    return this->m_score;
+    return ARCHETYPES[this->m_type].score;
+}
+
+double GameObject::GetRadius() const {
+    return ARCHETYPES[this->m_type].radiusFactor * this->GetSize();
+}
+
+const GameObject::Archetype& GameObject::GetArchetype(ObjectType type) {
+    return ARCHETYPES[type];
+}
+
+const GameObject::Archetype& GameObject::GetArchetype() const {
+    return ARCHETYPES[this->m_type];
 }
 
 bool GameObject::GetIsDead() const {
@@ -91,35 +188,154 @@ bool GameObject::GetIsDead() const {
 
 void GameObject::SetIsDead() {
     this->m_health = 0;
+    this->NotifyDead();
+}
+
+void GameObject::NotifyDead() {
+    if (!this->m_queuedDead) {
+        this->m_queuedDead = true;
+        this->GetGameWorld().OnObjectDead(*this);
+    }
 }
 
 bool GameObject::operator&(const GameObject& other) const {
     if (this->GetIsDead() || other.GetIsDead()) {
         return false;
     }
-    double d = sqrt(pow(this->GetX() - other.GetX(), 2) + 
-        pow(this->GetY() - other.GetY(), 2));
-    return d < 30.0 * (this->GetSize() + other.GetSize());
+    double dx = this->GetX() - other.GetX();
+    double dy = this->GetY() - other.GetY();
+    double r = this->GetRadius() + other.GetRadius();
+    return dx * dx + dy * dy < r * r;
+}
+
+bool GameObject::SweptHits(const GameObject& other) const {
+    const GameWorld& world = this->GetGameWorld();
+    GameWorld::Position from = world.GetStart(*this);
+    GameWorld::Position otherFrom = world.GetStart(other);
+    return this->SweptHits(from.x, from.y, other, otherFrom.x, otherFrom.y);
+}
+
+bool GameObject::SweptHits(int fromX, int fromY, const GameObject& other, 
+        int otherFromX, int otherFromY) const {
+    if (this->GetIsDead() || other.GetIsDead()) {
+        return false;
+    }
+    // In other's frame this object moves in a straight line from the
+    // difference of the start positions to that of the current ones; the
+    // closest approach to other's centre is found from the projection of
+    // the centre onto that segment clamped to its ends.
+    double fx = fromX - otherFromX;
+    double fy = fromY - otherFromY;
+    double dx = (this->GetX() - other.GetX()) - fx;
+    double dy = (this->GetY() - other.GetY()) - fy;
+    double length2 = dx * dx + dy * dy;
+    double t = 0.0;
+    if (length2 > 0.0) {
+        t = std::min(std::max(-(fx * dx + fy * dy) / length2, 0.0), 1.0);
+    }
+    double cx = fx + t * dx;
+    double cy = fy + t * dy;
+    double r = this->GetRadius() + other.GetRadius();
+    return cx * cx + cy * cy < r * r;
+}
+
+void GameObject::Save(SnapshotWriter& out) const {
+    out.Write<int>(this->GetX());
+    out.Write<int>(this->GetY());
+    out.Write<short>(static_cast<short>(this->GetDirection()));
+    out.Write<double>(this->GetSize());
+    out.Write<int>(this->m_health);
+    out.Write<int>(this->m_cold.damage);
+    out.Write<int>(this->m_speed);
+    // What the next tick starts with
+    out.Write<int>(this->EnergyAt(this->GetGameWorld().GetTick() + 1));
+}
+
+void GameObject::Load(SnapshotReader& in) {
+    int x = in.Read<int>();
+    int y = in.Read<int>();
+    this->MoveTo(x, y);
+    this->SetDirection(in.Read<short>());
+    this->SetSize(in.Read<double>());
+    this->m_health = in.Read<int>();
+    this->m_cold.damage = in.Read<int>();
+    this->m_speed = static_cast<int16_t>(in.Read<int>());
+    // Ticks until full, from the next tick on; see Resume()
+    this->m_cold.energyFull = this->GetMaxEnergy() - in.Read<int>();
+}
+
+void GameObject::Resume() {
+    this->m_cold.energyFull += this->GetGameWorld().GetTick() + 1;
+}
+
+std::unique_ptr<GameObject> GameObject::Create(ObjectType type) {
+    switch (type) {
+    case TypePlayer:
+        return std::make_unique<Player>(0, 0, 0, 1.0);
+    case TypeMeteor:
+        return std::make_unique<Meteor>(0, 0, 0, 2.0);
+    case TypeBlueBullet:
+        return std::make_unique<BlueBullet>(0, 0, 0, 0.5, 0);
+    case TypeRedBullet:
+        return std::make_unique<RedBullet>(0, 0, 180, 0.5, 0);
+    case TypeAlphaShip:
+        return std::make_unique<AlphaShip>(0, 0, 180, 1.0, 1, 0, 0);
+    case TypeSigmaShip:
+        return std::make_unique<SigmaShip>(0, 0, 180, 1.0, 1, 0);
+    case TypeOmegaShip:
+        return std::make_unique<OmegaShip>(0, 0, 180, 1.0, 1, 0, 0);
+    case TypeHealthWidget:
+        return std::make_unique<HealthWidget>(0, 0, 0, 0.5);
+    case TypeUpgradeWidget:
+        return std::make_unique<UpgradeWidget>(0, 0, 0, 0.5);
+    case TypeMeteorWidget:
+        return std::make_unique<MeteorWidget>(0, 0, 0, 0.5);
+    default:
+        return nullptr;
+    }
+}
+
+const char* GameObject::TypeName(ObjectType type) {
+    static const char* const names[TYPE_COUNT] = {
+        "Player", "Meteor", "BlueBullet", "RedBullet", 
+        "AlphaShip", "SigmaShip", "OmegaShip", 
+        "HealthWidget", "UpgradeWidget", "MeteorWidget"
+    };
+    return type >= 0 && type < TYPE_COUNT ? names[type] : "Unknown";
+}
+
+std::size_t GameObject::SizeOf(ObjectType type) {
+    switch (type) {
+    case TypePlayer: return sizeof(Player);
+    case TypeMeteor: return sizeof(Meteor);
+    case TypeBlueBullet: return sizeof(BlueBullet);
+    case TypeRedBullet: return sizeof(RedBullet);
+    case TypeAlphaShip: return sizeof(AlphaShip);
+    case TypeSigmaShip: return sizeof(SigmaShip);
+    case TypeOmegaShip: return sizeof(OmegaShip);
+    case TypeHealthWidget: return sizeof(HealthWidget);
+    case TypeUpgradeWidget: return sizeof(UpgradeWidget);
+    case TypeMeteorWidget: return sizeof(MeteorWidget);
+    default: return 0;
+    }
 }
 
 
 //////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////Player////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-Player::Player(int imageID, int x, int y, int direction, 
-        int layer, double size, GameWorld& gameWorld):
-    GameObject(imageID, x, y, direction, layer, size, gameWorld, 
-        ObjectType::TypePlayer, 100, 0, 4, 10, 0), 
+Player::Player(int x, int y, int direction, double size):
+    GameObject(ObjectType::TypePlayer, x, y, direction, size, 100, 0), 
     m_upgrade(0), m_meteor(0), m_destroyed(0) { }
-// x = 300, y = 100, direction = 0, layer = 0, size = 1.0
-// health = 100, energy = 10, upgrade = 0, meteor = 0, destroyed = 0
+// x = 300, y = 100, direction = 0, size = 1.0
+// health = 100, upgrade = 0, meteor = 0, destroyed = 0
 
 int Player::GetUpgrade() const {
     return this->m_upgrade;
 }
 
 void Player::SetUpgrade(int upgrade) {
-    this->m_upgrade = upgrade;
+    this->m_upgrade = static_cast<int16_t>(upgrade);
 }
 
 int Player::GetMeteor() const {
@@ -127,7 +343,7 @@ int Player::GetMeteor() const {
 }
 
 void Player::SetMeteor(int meteor) {
-    this->m_meteor = meteor;
+    this->m_meteor = static_cast<int16_t>(meteor);
 }
 
 int Player::GetDestroyed() const {
@@ -137,6 +353,20 @@ int Player::GetDestroyed() const {
 void Player::SetDestroyed(int destroyed) {
     this->m_destroyed = destroyed;
 }
+
+void Player::Save(SnapshotWriter& out) const {
+    GameObject::Save(out);
+    out.Write<int>(this->m_upgrade);
+    out.Write<int>(this->m_meteor);
+    out.Write<int>(this->m_destroyed);
+}
+
+void Player::Load(SnapshotReader& in) {
+    GameObject::Load(in);
+    this->m_upgrade = static_cast<int16_t>(in.Read<int>());
+    this->m_meteor = static_cast<int16_t>(in.Read<int>());
+    this->m_destroyed = in.Read<int>();
+}
     
 void Player::Update() {
     // Check if the player is dead
@@ -159,15 +389,20 @@ void Player::Update() {
     }
 
     // Listen to shoot1 request
-    if (this->GetGameWorld().GetKey(KeyCode::FIRE1) && this->GetEnergy() >= 10) {
-        this->SetEnergy(this->GetEnergy() - 10);
+    const StressConfig& stress = this->GetGameWorld().GetStressConfig();
+    bool fire = stress.autoFire || this->GetGameWorld().GetKey(KeyCode::FIRE1);
+    bool ready = this->GetEnergy() >= this->GetMaxEnergy();
+    if (stress.fireInterval > 0) {
+        ready = this->GetGameWorld().GetTick() % stress.fireInterval == 0;
+    }
+    if (fire && ready) {
+        if (stress.fireInterval == 0) {
+            this->SetEnergy(this->GetEnergy() - this->GetMaxEnergy());
+        }
         this->GetGameWorld().AddObject(std::make_unique<BlueBullet>(
-            IMGID_BLUE_BULLET, // imageID
             this->GetX(), this->GetY() + 50, // x, y
             0, // direction
-            1, // layer
             0.5 + 0.1 * this->m_upgrade, // size
-            this->GetGameWorld(), // gameWorld
             5 + 3 * this->m_upgrade //damage
         ));
     }
@@ -176,71 +411,19 @@ void Player::Update() {
     if (this->GetGameWorld().GetKeyDown(KeyCode::FIRE2) && this->m_meteor > 0) {
         this->m_meteor--;
         this->GetGameWorld().AddObject(std::make_unique<Meteor>(
-            IMGID_METEOR, // imageID
             this->GetX(), this->GetY() + 100, // x, y
             0, // direction
-            1, // layer
-            2.0, // size
-            this->GetGameWorld() // gameWorld
+            2.0 // size
         ));
     }
-
-    // Restore energy
-    if (this->GetEnergy() < 10) {
-        this->SetEnergy(this->GetEnergy() + 1);
-    }
-}
-
-
-//////////////////////////////////////////////////////////////////////////
-/////////////////////////////////////Star/////////////////////////////////
-//////////////////////////////////////////////////////////////////////////
-Star::Star(int imageID, int x, int y, int direction, 
-        int layer, double size, GameWorld& gameWorld): 
-    GameObject(imageID, x, y, direction, layer, size, gameWorld, 
-        ObjectType::TypeStar, 1, 0, 1, 0, 0) { }
-// x = ?, y = ?, direction = 0, layer = 4, size = ?
-
-void Star::Update() {
-    // Check if the star is dead
-    if (this->GetY() < 0) {
-        this->SetIsDead();
-        return;
-    }
-
-    // Move the star
-    this->MoveTo(this->GetX(), this->GetY() - 1);
-}
-
-
-//////////////////////////////////////////////////////////////////////////
-/////////////////////////////////Explosion////////////////////////////////
-//////////////////////////////////////////////////////////////////////////
-Explosion::Explosion(int imageID, int x, int y, int direction, 
-        int layer, double size, GameWorld& gameWorld): 
-    GameObject(imageID, x, y, direction, layer, size, gameWorld, 
-        ObjectType::TypeExplosion, 1, 0, 0, 0, 0), 
-    m_time(0) { }
-
-void Explosion::Update() {
-    // Update explosion size
-    this->SetSize(this->GetSize() - 0.2);
-
-    // Check if the explosion is finished
-    this->m_time++;
-    if (this->m_time >= 20) {
-        this->SetIsDead();
-    }
 }
 
 
 //////////////////////////////////////////////////////////////////////////
 ////////////////////////////////BlueBullet////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-BlueBullet::BlueBullet(int imageID, int x, int y, int direction, 
-        int layer, double size, GameWorld& gameWorld, int damage): 
-    GameObject(imageID, x, y, direction, layer, size, gameWorld, 
-        ObjectType::TypeBlueBullet, 1, damage, 6, 0, 0) { }
+BlueBullet::BlueBullet(int x, int y, int direction, double size, int damage): 
+    GameObject(ObjectType::TypeBlueBullet, x, y, direction, size, 1, damage) { }
 
 void BlueBullet::Update() {
     // Check if the bullet is dead
@@ -254,17 +437,25 @@ void BlueBullet::Update() {
         return;
     }
 
-    // Check if the bullet hit the enemy
-    std::for_each(this->GetGameWorld().GetObjects().begin(), 
-        this->GetGameWorld().GetObjects().end(), 
-        [this](std::unique_ptr<GameObject>& obj) {
+    // Move the bullet
+    this->MoveTo(this->GetX(), this->GetY() + this->GetSpeed());
+
+    // Check if the bullet hit an enemy anywhere on their ways; enemies that
+    // update later test the bullet themselves
+    GameWorld& world = this->GetGameWorld();
+    GameWorld::Position from = world.GetStart(*this);
+    std::for_each(world.GetObjects().begin(), world.GetObjects().end(), 
+        [this, &world, from](std::unique_ptr<GameObject>& obj) {
             if (obj->GetIsDead()) {
                 return;
             }
             ObjectType type = obj->GetType();
-            if (type == TypeAlphaShip || type == TypeSigmaShip || type == TypeOmegaShip) {
-                if (*obj & *this) {
+            if ((type == TypeAlphaShip || type == TypeSigmaShip || type == TypeOmegaShip) 
+                && world.UpdatesBefore(*obj, *this)) {
+                GameWorld::Position start = world.GetStart(*obj);
+                if (this->SweptHits(from.x, from.y, *obj, start.x, start.y)) {
                     obj->SetHealth(obj->GetHealth() - this->GetDamage());
+                    RecordDamage(*obj, this->GetDamage(), TypeBlueBullet);
                     this->SetIsDead();
                     if (obj->GetIsDead()) {
                         Destroy(obj);
@@ -274,41 +465,14 @@ void BlueBullet::Update() {
             }
         }
     );
-
-    // Move the bullet
-    this->MoveTo(this->GetX(), this->GetY() + 6);
-
-    // Recheck if the bullet hit the enemy
-    std::for_each(this->GetGameWorld().GetObjects().begin(), 
-        this->GetGameWorld().GetObjects().end(), 
-        [this](std::unique_ptr<GameObject>& obj) {
-            if (obj->GetIsDead()) {
-                return;
-            }            
-            ObjectType type = obj->GetType();
-            if (type == TypeAlphaShip || type == TypeSigmaShip || type == TypeOmegaShip) {
-                if (*obj & *this) {
-                    obj->SetHealth(obj->GetHealth() - this->GetDamage());
-                    this->SetIsDead();
-                    if (obj->GetIsDead()) {
-                        Destroy(obj);
-                    }
-                    return;
-                }
-            }
-        }
-    );    
-
 }
 
 
 //////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////Meteor////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-Meteor::Meteor(int imageID, int x, int y, int direction, 
-        int layer, double size, GameWorld& gameWorld): 
-    GameObject(imageID, x, y, direction, layer, size, gameWorld, 
-    ObjectType::TypeMeteor, 1, 1e5, 2, 0, 0) { }
+Meteor::Meteor(int x, int y, int direction, double size): 
+    GameObject(ObjectType::TypeMeteor, x, y, direction, size, 1, 1e5) { }
 
 void Meteor::Update() {
     // Check if the meteor is dead
@@ -322,37 +486,24 @@ void Meteor::Update() {
         return;
     }
 
-    // Check if the meteor hit the enemy
-    std::for_each(this->GetGameWorld().GetObjects().begin(), 
-        this->GetGameWorld().GetObjects().end(), 
-        [this](std::unique_ptr<GameObject>& obj) {
-            if (obj->GetIsDead()) {
-                return;
-            }
-            ObjectType type = obj->GetType();
-            if (type == TypeAlphaShip || type == TypeSigmaShip || type == TypeOmegaShip) {
-                if (*obj & *this) {
-                    Destroy(obj);                     
-                    return;
-                }
-            }
-        }
-    );
-
     // Move the meteor
-    this->MoveTo(this->GetX(), this->GetY() + 2);
+    this->MoveTo(this->GetX(), this->GetY() + this->GetSpeed());
     this->SetDirection((this->GetDirection() + 5) % 360);
 
-    // Recheck if the meteor hit the enemy
-    std::for_each(this->GetGameWorld().GetObjects().begin(), 
-        this->GetGameWorld().GetObjects().end(), 
-        [this](std::unique_ptr<GameObject>& obj) {
+    // Check if the meteor hit an enemy anywhere on their ways; enemies that
+    // update later test the meteor themselves
+    GameWorld& world = this->GetGameWorld();
+    GameWorld::Position from = world.GetStart(*this);
+    std::for_each(world.GetObjects().begin(), world.GetObjects().end(), 
+        [this, &world, from](std::unique_ptr<GameObject>& obj) {
             if (obj->GetIsDead()) {
                 return;
-            }            
+            }
             ObjectType type = obj->GetType();
-            if (type == TypeAlphaShip || type == TypeSigmaShip || type == TypeOmegaShip) {
-                if (*obj & *this) {
+            if ((type == TypeAlphaShip || type == TypeSigmaShip || type == TypeOmegaShip) 
+                && world.UpdatesBefore(*obj, *this)) {
+                GameWorld::Position start = world.GetStart(*obj);
+                if (this->SweptHits(from.x, from.y, *obj, start.x, start.y)) {
                     Destroy(obj);
                     return;
                 }
@@ -365,10 +516,8 @@ void Meteor::Update() {
 //////////////////////////////////////////////////////////////////////////
 /////////////////////////////////RedBullet////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-RedBullet::RedBullet(int imageID, int x, int y, int direction, 
-        int layer, double size, GameWorld& gameWorld, int damage): 
-    GameObject(imageID, x, y, direction, layer, size, gameWorld, 
-        ObjectType::TypeRedBullet, 1, damage, 2, 0, 0) { }
+RedBullet::RedBullet(int x, int y, int direction, double size, int damage): 
+    GameObject(ObjectType::TypeRedBullet, x, y, direction, size, 1, damage) { }
 
 void RedBullet::Update() {
     // Check if the bullet is dead
@@ -382,88 +531,109 @@ void RedBullet::Update() {
         return;
     }
 
-    // Check if the bullet hit the player
-    if (*this & *this->GetGameWorld().m_player) {
-        this->GetGameWorld().m_player->SetHealth(
-            this->GetGameWorld().m_player->GetHealth() - this->GetDamage());
-        this->SetIsDead();
-        return;
-    }
-
     // Move the bullet
     if (this->GetDirection() == 180) {
-        this->MoveTo(this->GetX(), this->GetY() - 6);
+        this->MoveTo(this->GetX(), this->GetY() - this->GetSpeed());
     } else if (this->GetDirection() == 162) {
-        this->MoveTo(this->GetX() + 2, this->GetY() - 6);
+        this->MoveTo(this->GetX() + 2, this->GetY() - this->GetSpeed());
     } else if (this->GetDirection() == 198) {
-        this->MoveTo(this->GetX() - 2, this->GetY() - 6);
+        this->MoveTo(this->GetX() - 2, this->GetY() - this->GetSpeed());
     }
 
-    // Recheck if the bullet hit the player
-    if (*this & *this->GetGameWorld().m_player) {
+    // Check if the bullet hit the player anywhere on its way
+    if (this->SweptHits(*this->GetGameWorld().m_player)) {
         this->GetGameWorld().m_player->SetHealth(
             this->GetGameWorld().m_player->GetHealth() - this->GetDamage());
+        RecordDamage(*this->GetGameWorld().m_player, this->GetDamage(), TypeRedBullet);
         this->SetIsDead();
         return;
-    }    
+    }
 }
 
 
 //////////////////////////////////////////////////////////////////////////
 /////////////////////////////////EnemyShip////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-EnemyShip::EnemyShip(int imageID, int x, int y, int direction, int layer, 
-        double size, GameWorld& gameWorld, ObjectType type, int health, 
-        int damage, int speed, int energy, int score, int time, int strategy): 
-    GameObject(imageID, x, y, direction, layer, size, gameWorld,
-        type, health, damage, speed, energy, score), 
-    m_time(time), m_strategy(strategy) { }
+EnemyShip::EnemyShip(ObjectType type, int x, int y, int direction, 
+        double size, int health, int damage, int speed, int time, int strategy): 
+    GameObject(type, x, y, direction, size, health, damage), 
+    m_timeUp(0), m_strategy(0) { 
+    this->SetSpeed(speed);
+    this->SetTime(time);
+    this->SetStrategy(strategy);
+}
 
 int EnemyShip::GetTime() const {
-    return this->m_time;
+    uint16_t now = static_cast<uint16_t>(this->GetGameWorld().GetTick());
+    return std::max(0, static_cast<int>(static_cast<int16_t>(this->m_timeUp - now)));
 }
 
 void EnemyShip::SetTime(int time) {
-    this->m_time = time;
+    this->m_timeUp = static_cast<uint16_t>(this->GetGameWorld().GetTick() + std::max(time, 0));
 }
 
 int EnemyShip::GetStrategy() const {
-    return this->m_strategy;
+    return 180 + this->m_strategy;
 }
 
 void EnemyShip::SetStrategy(int strategy) {
-    this->m_strategy = strategy;
+    this->m_strategy = static_cast<int8_t>(strategy - 180);
+}
+
+void EnemyShip::Save(SnapshotWriter& out) const {
+    GameObject::Save(out);
+    // What the next tick starts with
+    out.Write<int>(std::max(this->GetTime() - 1, 0));
+    out.Write<int>(this->GetStrategy());
+}
+
+void EnemyShip::Load(SnapshotReader& in) {
+    GameObject::Load(in);
+    // Kept until Resume() can rebase it
+    this->m_timeUp = static_cast<uint16_t>(in.Read<int>());
+    this->SetStrategy(in.Read<int>());
+}
+
+void EnemyShip::Resume() {
+    GameObject::Resume();
+    this->SetTime(static_cast<int16_t>(this->m_timeUp) + 1);
 }
 
 void EnemyShip::Rebirth() { }
 
 void EnemyShip::Attack() { }
 
-void EnemyShip::Refuel() { }
-
 bool EnemyShip::Collapse() {
-    std::for_each(this->GetGameWorld().GetObjects().begin(), 
-        this->GetGameWorld().GetObjects().end(), 
-        [this](std::unique_ptr<GameObject>& obj) {
+    // Bullets and meteors that update later test the ship themselves
+    GameWorld& world = this->GetGameWorld();
+    GameWorld::Position from = world.GetStart(*this);
+    std::for_each(world.GetObjects().begin(), world.GetObjects().end(), 
+        [this, &world, from](std::unique_ptr<GameObject>& obj) {
             if (obj->GetIsDead()) {
                 return;
             }
             ObjectType type = obj->GetType();
+            if ((type != TypeBlueBullet && type != TypeMeteor) || !world.UpdatesBefore(*obj, *this)) {
+                return;
+            }
+            GameWorld::Position start = world.GetStart(*obj);
             if (type == TypeBlueBullet) {
-                if (*obj & *this) {
+                if (this->SweptHits(from.x, from.y, *obj, start.x, start.y)) {
                     this->SetHealth(this->GetHealth() - obj->GetDamage());                     
+                    RecordDamage(*this, obj->GetDamage(), TypeBlueBullet);
                     obj->SetIsDead();
                 }
             } else if (type == TypeMeteor) {
-                if (*obj & *this) {
+                if (this->SweptHits(from.x, from.y, *obj, start.x, start.y)) {
                     this->SetIsDead();
                 }
             }
         }
     );
-    if (*this & *this->GetGameWorld().m_player) {
+    if (this->SweptHits(*this->GetGameWorld().m_player)) {
         this->GetGameWorld().m_player->SetHealth(
             this->GetGameWorld().m_player->GetHealth() - 20);
+        RecordDamage(*this->GetGameWorld().m_player, 20, this->GetType());
         this->SetIsDead();
     }
     if (this->GetIsDead()) {
@@ -494,7 +664,6 @@ void EnemyShip::Choose() {
 }
 
 void EnemyShip::Move() {
-    this->SetTime(this->GetTime() - 1);
     if (this->GetStrategy()== 180) {
         this->MoveTo(this->GetX(), this->GetY() - this->GetSpeed());
     } else if (this->GetStrategy() == 198) {
@@ -516,51 +685,52 @@ void EnemyShip::Update() {
         return;
     }
 
-    // Check if the ship hit the player or his bullets
-    if (this->Collapse()) {
-        return;
-    }
-
     // Attack the player
     this->Attack();
 
-    // Fuel up energy
-    this->Refuel();
-
     // Generate new strategy
     this->Choose();
 
     // Move the ship
     this->Move();
 
-    // Recheck if the ship hit the player or his bullets
+    // Check if the ship hit the player or his bullets anywhere on its way
     if (this->Collapse()) {
         return;
-    }        
+    }
 }
 
 //////////////////////////////////////////////////////////////////////////
 /////////////////////////////////AlphaShip////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-AlphaShip::AlphaShip(int imageID, int x, int y, int direction, int layer, 
-        double size, GameWorld& gameWorld, int health, int damage, int speed): 
-    EnemyShip(imageID, x, y, direction, layer, size, gameWorld, 
-        ObjectType::TypeAlphaShip, health, damage, speed, 25, 50, 0, 180) {}
+AlphaShip::AlphaShip(int x, int y, int direction, double size, 
+        int health, int damage, int speed): 
+    EnemyShip(ObjectType::TypeAlphaShip, x, y, direction, size, 
+        health, damage, speed, 0, 180) {}
 
 void AlphaShip::Rebirth() { }
 
 void AlphaShip::Attack() { 
+    int interval = this->GetGameWorld().GetStressConfig().enemyFireInterval;
+    if (interval > 0) {
+        if (randInt(1, interval) == 1) {
+            this->GetGameWorld().AddObject(std::make_unique<RedBullet>(
+                this->GetX(), this->GetY() - 50, // x, y
+                180, // direction
+                0.5, // size
+                this->GetDamage() // damage
+            ));
+        }
+        return;
+    }
     if (abs(this->GetX() - this->GetGameWorld().m_player->GetX()) <= 10) {
-        if (this->GetEnergy() >= 25) {
+        if (this->GetEnergy() >= this->GetMaxEnergy()) {
             if (randInt(1, 100) <= 25) {
-                this->SetEnergy(this->GetEnergy() - 25);
+                this->SetEnergy(this->GetEnergy() - this->GetMaxEnergy());
                 this->GetGameWorld().AddObject(std::make_unique<RedBullet>(
-                    IMGID_RED_BULLET, // image id
                     this->GetX(), this->GetY() - 50, // x, y
                     180, // direction
-                    1, // layer
                     0.5, // size
-                    this->GetGameWorld(), // game world
                     this->GetDamage() // damage
                 ));
             }
@@ -568,30 +738,21 @@ void AlphaShip::Attack() {
     }
 }
 
-void AlphaShip::Refuel() {
-    if (this->GetEnergy() < 25) {
-        this->SetEnergy(this->GetEnergy() + 1);
-    }
-}
-
 
 //////////////////////////////////////////////////////////////////////////
 /////////////////////////////////SigmaShip////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-SigmaShip::SigmaShip(int imageID, int x, int y, int direction, int layer, 
-        double size, GameWorld& gameWorld, int health, int speed): 
-    EnemyShip(imageID, x, y, direction, layer, size, gameWorld, 
-        ObjectType::TypeSigmaShip, health, 0, speed, 0, 100, 0, 180) {}
+SigmaShip::SigmaShip(int x, int y, int direction, double size, 
+        int health, int speed): 
+    EnemyShip(ObjectType::TypeSigmaShip, x, y, direction, size, 
+        health, 0, speed, 0, 180) {}
 
 void SigmaShip::Rebirth() {
     if (randInt(1, 100) <= 20) {
         this->GetGameWorld().AddObject(std::make_unique<HealthWidget>(
-            IMGID_HP_RESTORE_GOODIE, // image id
             this->GetX(), this->GetY(), // x, y
             0, // direction
-            2, // layer
-            0.5, // size
-            this->GetGameWorld() // game world
+            0.5 // size
         ));
     }
 }
@@ -604,80 +765,64 @@ void SigmaShip::Attack() {
     }    
 }
 
-void SigmaShip::Refuel() { }
-
 
 //////////////////////////////////////////////////////////////////////////
 /////////////////////////////////OmegaShip////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-OmegaShip::OmegaShip(int imageID, int x, int y, int direction, int layer, 
-        double size, GameWorld& gameWorld, int health, int damage, int speed): 
-    EnemyShip(imageID, x, y, direction, layer, size, gameWorld, 
-        ObjectType::TypeOmegaShip, health, damage, speed, 50, 200, 0, 180) {}
+OmegaShip::OmegaShip(int x, int y, int direction, double size, 
+        int health, int damage, int speed): 
+    EnemyShip(ObjectType::TypeOmegaShip, x, y, direction, size, 
+        health, damage, speed, 0, 180) {}
 
 void OmegaShip::Rebirth() { 
     if (randInt(1, 100) <= 40) {
         if (randInt(1, 100) <= 80) {
             this->GetGameWorld().AddObject(std::make_unique<UpgradeWidget>(
-                IMGID_POWERUP_GOODIE, // image id
                 this->GetX(), this->GetY(), // x, y
                 0, // direction
-                2, // layer
-                0.5, // size
-                this->GetGameWorld() // game world
+                0.5 // size
             ));
         } else {
             this->GetGameWorld().AddObject(std::make_unique<MeteorWidget>(
-                IMGID_METEOR_GOODIE, // image id
                 this->GetX(), this->GetY(), // x, y
                 0, // direction
-                2, // layer
-                0.5, // size
-                this->GetGameWorld() // game world
+                0.5 // size
             ));
         }
     }
 }
 
 void OmegaShip::Attack() { 
-    if (this->GetEnergy() >= 50) {
-        this->SetEnergy(this->GetEnergy() - 50);
+    int interval = this->GetGameWorld().GetStressConfig().enemyFireInterval;
+    bool ready = this->GetEnergy() >= this->GetMaxEnergy();
+    if (interval > 0) {
+        ready = randInt(1, interval) == 1;
+    }
+    if (ready) {
+        if (interval == 0) {
+            this->SetEnergy(this->GetEnergy() - this->GetMaxEnergy());
+        }
         this->GetGameWorld().AddObject(std::make_unique<RedBullet>(
-            IMGID_RED_BULLET, // image id
             this->GetX(), this->GetY() - 50, // x, y
             162, // direction
-            1, // layer
             0.5, // size
-            this->GetGameWorld(), // game world
             this->GetDamage() // damage
         ));
         this->GetGameWorld().AddObject(std::make_unique<RedBullet>(
-            IMGID_RED_BULLET, // image id
             this->GetX(), this->GetY() - 50, // x, y
             198, // direction
-            1, // layer
             0.5, // size
-            this->GetGameWorld(), // game world
             this->GetDamage() // damage
         ));        
     }
 }
 
-void OmegaShip::Refuel() { 
-    if (this->GetEnergy() < 50) {
-        this->SetEnergy(this->GetEnergy() + 1);
-    }
-}
-
 
 //////////////////////////////////////////////////////////////////////////
 /////////////////////////////////SnackWidget//////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-SnackWidget::SnackWidget(int imageID, int x, int y, int direction, int layer, 
-        double size, GameWorld& gameWorld, ObjectType type, int health, 
-        int damage, int speed, int energy, int score): 
-    GameObject(imageID, x, y, direction, layer, size, gameWorld, 
-        type, health, damage, speed, energy, score) {}
+SnackWidget::SnackWidget(ObjectType type, int x, int y, int direction, double size): 
+    GameObject(type, x, y, direction, size, 1, 0) {}
 
 void SnackWidget::Update() {
     // Check if the widget is dead
@@ -691,33 +836,25 @@ void SnackWidget::Update() {
         return;
     }
 
-    // Check if the widget is colliding with the player
-    if (*this & *this->GetGameWorld().m_player) {
-        this->Effect();
-        this->GetGameWorld().IncreaseScore(this->GetScore());
-        this->SetIsDead();
-        return;
-    }
-
     // Move the widget
-    this->MoveTo(this->GetX(), this->GetY() - 2);
+    this->MoveTo(this->GetX(), this->GetY() - this->GetSpeed());
 
-    // Recheck if the widget is colliding with the player
-    if (*this & *this->GetGameWorld().m_player) {
+    // Check if the widget touched the player anywhere on its way
+    if (this->SweptHits(*this->GetGameWorld().m_player)) {
         this->Effect();
+        Telemetry::Instance().Emit(Telemetry::Kind::PICKUP, this->GetGameWorld().GetTick(), 
+            this->GetType());
         this->GetGameWorld().IncreaseScore(this->GetScore());
         this->SetIsDead();
         return;
-    }        
+    }
 }
 
 //////////////////////////////////////////////////////////////////////////
 ////////////////////////////////HealthWidget//////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-HealthWidget::HealthWidget(int imageID, int x, int y, int direction, 
-        int layer, double size, GameWorld& gameWorld): 
-    SnackWidget(imageID, x, y, direction, layer, size, gameWorld, 
-        ObjectType::TypeHealthWidget, 1, 0, 2, 0, 20) { }
+HealthWidget::HealthWidget(int x, int y, int direction, double size): 
+    SnackWidget(ObjectType::TypeHealthWidget, x, y, direction, size) { }
 
 void HealthWidget::Effect() {
     this->GetGameWorld().m_player->SetHealth(
@@ -728,10 +865,8 @@ void HealthWidget::Effect() {
 //////////////////////////////////////////////////////////////////////////
 ////////////////////////////////UpgradeWidget/////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-UpgradeWidget::UpgradeWidget(int imageID, int x, int y, int direction, 
-        int layer, double size, GameWorld& gameWorld): 
-    SnackWidget(imageID, x, y, direction, layer, size, gameWorld, 
-        ObjectType::TypeUpgradeWidget, 1, 0, 2, 0, 20) { }
+UpgradeWidget::UpgradeWidget(int x, int y, int direction, double size): 
+    SnackWidget(ObjectType::TypeUpgradeWidget, x, y, direction, size) { }
 
 void UpgradeWidget::Effect() {
     this->GetGameWorld().m_player->SetUpgrade(
@@ -742,10 +877,8 @@ void UpgradeWidget::Effect() {
 //////////////////////////////////////////////////////////////////////////
 ////////////////////////////////MeteorWidget//////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-MeteorWidget::MeteorWidget(int imageID, int x, int y, int direction, 
-        int layer, double size, GameWorld& gameWorld): 
-    SnackWidget(imageID, x, y, direction, layer, size, gameWorld, 
-        ObjectType::TypeMeteorWidget, 1, 0, 2, 0, 20) { }
+MeteorWidget::MeteorWidget(int x, int y, int direction, double size): 
+    SnackWidget(ObjectType::TypeMeteorWidget, x, y, direction, size) { }
 
 void MeteorWidget::Effect() {
     this->GetGameWorld().m_player->SetMeteor(
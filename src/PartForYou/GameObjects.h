@@ -1,8 +1,12 @@
 #ifndef GAMEOBJECTS_H__
 #define GAMEOBJECTS_H__
 
+#include <cstdint>
+#include <memory>
+
 #include "ObjectBase.h"
 #include "GameWorld.h"
+#include "WorldSnapshot.h"
 
 class GameWorld;
 
@@ -30,8 +34,6 @@ public:
 
     using ObjectType = enum {
         TypePlayer,
-        TypeStar, 
-        TypeExplosion, 
         TypeMeteor,
         TypeBlueBullet,
         TypeRedBullet,
@@ -43,10 +45,32 @@ public:
         TypeMeteorWidget
     };
 
-    GameObject(int, int, int, int, int, double, 
-        GameWorld& gameWorld, ObjectType, int, int, int, int, int);
-    virtual ~GameObject() = default;
+    static const int TYPE_COUNT = 10;
+
+    // What every object of a type has in common. One constexpr table holds
+    // these for all types, so objects only carry their own state and the
+    // collision and energy code reads a table that stays in cache.
+    struct Archetype {
+        uint8_t imageID;
+        uint8_t layer;
+        // Pixels per tick; ships are given theirs by the level.
+        int16_t speed;
+        // Scored for destroying or picking up the object.
+        int16_t score;
+        // Energy to fire, and what objects start with.
+        int16_t maxEnergy;
+        // Collision radius per unit of size.
+        float radiusFactor;
+    };
+
+    // Image ID, layer, speed and energy come from the archetype of the type.
+    GameObject(ObjectType, int, int, int, double, int, int);
+    virtual ~GameObject();
 
+    static const Archetype& GetArchetype(ObjectType);
+    const Archetype& GetArchetype() const;
+
+    // The world whose ObjectPool holds the object.
     GameWorld& GetGameWorld() const;
     ObjectType GetType() const;
     int GetHealth() const;
@@ -55,24 +79,67 @@ public:
     void SetDamage(int);
     int GetSpeed() const;
     void SetSpeed(int);
+    // Energy refills by one per tick up to the maximum without being
+    // updated: it is kept as the tick from which it is full again.
     int GetEnergy() const;
     void SetEnergy(int);   
-    int GetScore() const; 
+    int GetMaxEnergy() const;
+    int GetScore() const;
+    double GetRadius() const;
 
     bool GetIsDead() const;
     void SetIsDead();
 
     bool operator&(const GameObject&) const;
+    // Swept version of operator&: whether the two objects touched anywhere
+    // while both moved in a straight line from where they were when the
+    // tick's updates began (GameWorld::GetStart) to where they are now.
+    bool SweptHits(const GameObject&) const;
+    // The same with both start positions at hand, for scans over many
+    // objects.
+    bool SweptHits(int fromX, int fromY, const GameObject&, int otherFromX, int otherFromY) const;
+
+    // Storage comes from the current world's ObjectPool, so objects are
+    // created inside a WorldBase::Scope of their GameWorld. It goes back to
+    // the pool it came from on delete, from any thread and any scope.
+    static void* operator new(std::size_t);
+    static void operator delete(void*, std::size_t);
+
+    // Snapshot support: subclasses append their own state after calling
+    // the base version. Snapshots hold countdowns relative to the tick they
+    // were taken at; Resume() rebases them once the restored world has its
+    // tick back.
+    virtual void Save(SnapshotWriter&) const;
+    virtual void Load(SnapshotReader&);
+    virtual void Resume();
+
+    // Creates a default object of the given type to Load() a snapshot into.
+    static std::unique_ptr<GameObject> Create(ObjectType);
+    static std::size_t SizeOf(ObjectType);
+    static const char* TypeName(ObjectType);
 
 private:
 
-    GameWorld& m_gameWorld;
-    ObjectType m_type;
-    int m_health;
-    int m_damage;
-    int m_speed;
-    int m_energy;
-    int m_score;
+    friend class GameWorld;
+
+    // Queues the object for compaction the first time it dies.
+    void NotifyDead();
+    // As it will be at the start of the given tick.
+    int EnergyAt(int tick) const;
+
+    // Hot: read by every collision scan and movement step, these share the
+    // first 32 bytes with ObjectBase's position and size.
+    int32_t m_health;
+    uint8_t m_type;
+    bool m_queuedDead;
+    int16_t m_speed;
+
+    // Cold: only read when something hits, fires or dies.
+    struct ColdStats {
+        int32_t damage;
+        int32_t slot;
+        int32_t energyFull;
+    } m_cold;
     
 };
 
@@ -83,7 +150,7 @@ class Player : public GameObject {
 
 public:
 
-    Player(int, int, int, int, int, double, GameWorld&);
+    Player(int, int, int, double);
     virtual ~Player() = default;
 
     void Update() override;
@@ -95,49 +162,14 @@ public:
     int GetDestroyed() const;
     void SetDestroyed(int);
 
-private:
-
-    int m_upgrade;
-    int m_meteor;
-    int m_destroyed;
-
-};
-
-
-//////////////////////////////////////////////////////////////////////////
-/////////////////////////////////////Star/////////////////////////////////
-//////////////////////////////////////////////////////////////////////////
-class Star : public GameObject {
-
-public:
-
-    Star(int, int, int, int, int, double, GameWorld&);
-    virtual ~Star() = default;
-
-    void Update() override;
+    void Save(SnapshotWriter&) const override;
+    void Load(SnapshotReader&) override;
 
 private:
 
-
-
-};
-
-
-//////////////////////////////////////////////////////////////////////////
-/////////////////////////////////Explosion////////////////////////////////
-//////////////////////////////////////////////////////////////////////////
-class Explosion : public GameObject {
-
-public:
-
-    Explosion(int, int, int, int, int, double, GameWorld&);
-    virtual ~Explosion() = default;
-
-    void Update() override;
-
-private:
-
-    int m_time;
+    int16_t m_upgrade;
+    int16_t m_meteor;
+    int32_t m_destroyed;
 
 };
 
@@ -149,7 +181,7 @@ class BlueBullet : public GameObject {
 
 public:
 
-    BlueBullet(int, int, int, int, int, double, GameWorld&, int);
+    BlueBullet(int, int, int, double, int);
     virtual ~BlueBullet() = default;
 
     void Update() override;
@@ -168,7 +200,7 @@ class Meteor : public GameObject {
 
 public:
 
-    Meteor(int, int, int, int, int, double, GameWorld&);
+    Meteor(int, int, int, double);
     virtual ~Meteor() = default;
 
     void Update() override;
@@ -187,7 +219,7 @@ class RedBullet : public GameObject {
 
 public:
 
-    RedBullet(int, int, int, int, int, double, GameWorld&, int);
+    RedBullet(int, int, int, double, int);
     virtual ~RedBullet() = default;
 
     void Update() override;
@@ -206,12 +238,14 @@ class EnemyShip : public GameObject {
 
 public:
 
-    EnemyShip(int, int, int, int, int, double, GameWorld&, ObjectType, 
-        int, int, int, int, int, int, int);
+    EnemyShip(ObjectType, int, int, int, double, 
+        int, int, int, int, int);
     virtual ~EnemyShip() = default;
 
     void Update() override;
 
+    // Ticks the current strategy has left, derived from the world tick
+    // instead of counted down on every update.
     int GetTime() const;
     void SetTime(int);
     int GetStrategy() const;
@@ -223,12 +257,19 @@ public:
 
     virtual void Rebirth();
     virtual void Attack();
-    virtual void Refuel();
+
+    void Save(SnapshotWriter&) const override;
+    void Load(SnapshotReader&) override;
+    void Resume() override;
 
 private:
 
-    int m_time;
-    int m_strategy;
+    // Low 16 bits of the tick the strategy runs out at; strategies last at
+    // most a screen height of ticks and ships reroll the tick theirs runs
+    // out, so the distance to the world tick always fits 16 bits.
+    uint16_t m_timeUp;
+    // Heading relative to straight down (180).
+    int8_t m_strategy;
 
 };
 
@@ -240,12 +281,11 @@ class AlphaShip : public EnemyShip {
 
 public:
 
-    AlphaShip(int, int, int, int, int, double, GameWorld&, int, int, int);
+    AlphaShip(int, int, int, double, int, int, int);
     virtual ~AlphaShip() = default;
 
     void Rebirth() override;
     void Attack() override;    
-    void Refuel() override;
 
 private:
 
@@ -261,12 +301,11 @@ class SigmaShip : public EnemyShip {
 
 public:
 
-    SigmaShip(int, int, int, int, int, double, GameWorld&, int, int);
+    SigmaShip(int, int, int, double, int, int);
     virtual ~SigmaShip() = default;  
 
     void Rebirth() override;
     void Attack() override;
-    void Refuel() override;
 
 private:
 
@@ -282,12 +321,11 @@ class OmegaShip : public EnemyShip {
 
 public:
 
-    OmegaShip(int, int, int, int, int, double, GameWorld&, int, int, int);
+    OmegaShip(int, int, int, double, int, int, int);
     virtual ~OmegaShip() = default;
 
     void Rebirth() override;
     void Attack() override;
-    void Refuel() override;
 
 private:
 
@@ -303,8 +341,7 @@ class SnackWidget : public GameObject {
 
 public:
 
-    SnackWidget(int, int, int, int, int, double, GameWorld&, ObjectType, 
-        int, int, int, int, int);
+    SnackWidget(ObjectType, int, int, int, double);
     virtual ~SnackWidget() = default;
 
     void Update() override;
@@ -325,7 +362,7 @@ class HealthWidget : public SnackWidget {
 
 public:
 
-    HealthWidget(int, int, int, int, int, double, GameWorld&);
+    HealthWidget(int, int, int, double);
     virtual ~HealthWidget() = default;
 
     void Effect() override;
@@ -343,7 +380,7 @@ class UpgradeWidget : public SnackWidget {
 
 public:
 
-    UpgradeWidget(int, int, int, int, int, double, GameWorld&);
+    UpgradeWidget(int, int, int, double);
     virtual ~UpgradeWidget() = default;
 
     void Effect() override;
@@ -362,7 +399,7 @@ class MeteorWidget : public SnackWidget {
 
 public:
 
-    MeteorWidget(int, int, int, int, int, double, GameWorld&);
+    MeteorWidget(int, int, int, double);
     virtual ~MeteorWidget() = default;
 
     void Effect() override;
@@ -1,20 +1,53 @@
+#include <array>
+#include <iostream>
 #include <sstream>
 
 #include "GameWorld.h"
+#include "ObjectPool.h"
+#include "PerfCounters.h"
+#include "Telemetry.h"
+#include "TraceRecorder.h"
 
-GameWorld::GameWorld(): m_life(3), m_player(), m_data() { }
+GameWorld::GameWorld(): m_player(), m_pool(*this), m_life(3), m_tick(0), m_stress(), 
+    m_data(), m_spawned(), m_starts(), m_playerStart(), m_dead(), m_particles(this->GetContext().registry), m_governor(), m_levelStart(), m_levelStartLevel(0), 
+    m_pendingRestore(), m_checkpointFile() { }
+
+GameWorld::~GameWorld() {
+    // Objects hand their storage back to m_pool and unregister from this
+    // world, so they have to go while the world is still whole.
+    this->CleanUp();
+}
 
 void GameWorld::Init() {
+    WorldBase::Scope scope(*this);
+    TraceRecorder::Scope trace("world", "GameWorld::Init");
+
+    // Resume from a checkpoint
+    if (!this->m_pendingRestore.empty()) {
+        Snapshot checkpoint;
+        checkpoint.swap(this->m_pendingRestore);
+        if (this->RestoreSnapshot(checkpoint)) {
+            this->m_levelStart.swap(checkpoint);
+            this->m_levelStartLevel = this->GetLevel();
+            return;
+        }
+        std::cerr << "Invalid checkpoint, starting a new game" << std::endl;
+    }
+
+    // Retry the level from its saved start
+    if (this->m_levelStartLevel == this->GetLevel() 
+            && this->RestoreSnapshot(this->m_levelStart, true)) {
+        return;
+    }
+
     // Initialize game status
+    this->m_tick = 0;
 
     // Add player
     this->m_player = std::make_unique<Player>(
-        IMGID_DAWNBREAKER, // image id
         300, 100, // x, y
         0, // direction
-        0, // layer
-        1.0, // size
-        *this // game world
+        1.0 // size
     );
 
     // Add stars
@@ -22,31 +55,51 @@ void GameWorld::Init() {
         int x = randInt(0, WINDOW_WIDTH - 1);
         int y = randInt(0, WINDOW_HEIGHT - 1);
         double size = randInt(10, 40) / 100.00;
-        this->m_data.push_back(std::make_unique<Star>(
-            IMGID_STAR, // image id
-            x, y, // x, y
-            0, // direction
-            4, // layer
-            size, // size
-            *this // game world
-        ));
+        this->m_particles.SpawnStar(x, y, size);
+    }
+
+    // Remember the level start
+    this->SaveSnapshot(this->m_levelStart);
+    this->m_levelStartLevel = this->GetLevel();
+    if (!this->m_checkpointFile.empty() 
+            && !WriteSnapshotFile(this->m_checkpointFile, this->m_levelStart)) {
+        std::cerr << "Cannot write checkpoint '" << this->m_checkpointFile << "'" << std::endl;
     }
 }
 
 LevelStatus GameWorld::Update() {
-    // Add status
-    if (randInt(1, 30) == 1) {
+    WorldBase::Scope scope(*this);
+    TraceRecorder& trace = TraceRecorder::Instance();
+    TraceRecorder::Scope traceUpdate("world", "GameWorld::Update");
+    // Ticks that end the level are left out of the TICK phase.
+    PerfCounters& perf = PerfCounters::Instance();
+    perf.Begin(PerfCounters::Phase::TICK);
+    this->m_governor.BeginTick();
+    this->m_tick++;
+    Telemetry& telemetry = Telemetry::Instance();
+    // Every attempt starts from a tick 0 snapshot.
+    if (this->m_tick == 1) {
+        telemetry.Emit(Telemetry::Kind::LEVEL_START, this->m_tick, this->GetLevel(), this->m_life);
+    }
+
+    // Add stars
+    trace.Begin("world", "Spawn");
+    perf.Begin(PerfCounters::Phase::SPAWN);
+    int stars = this->m_stress.starsPerTick;
+    if (stars == 0) {
+        stars = randInt(1, 30) == 1 ? 1 : 0;
+    }
+    for (int i = 0; i < stars; i++) {
         int x = randInt(0, WINDOW_WIDTH - 1);
         int y = WINDOW_HEIGHT - 1;
         double size = randInt(10, 40) / 100.00;
-        this->m_data.push_back(std::make_unique<Star>(
-            IMGID_STAR, // image id 
-            x, y, // x, y
-            0, // direction
-            4, // layer
-            size, // size
-            *this // game world
-        ));
+        // Thinned out only after the random numbers are drawn, so that the
+        // governor does not change play
+        if (this->m_governor.IsOn(FrameGovernor::Step::FEWER_STARS) 
+                && (this->m_tick + i) % FrameGovernor::STAR_DIVISOR != 0) {
+            continue;
+        }
+        this->m_particles.SpawnStar(x, y, size);
     }
 
     // Decide if add ship
@@ -56,6 +109,9 @@ LevelStatus GameWorld::Update() {
     int toDestroy = required - destroyed;
     int maxOnScreen = (5 + level) / 2;
     int allowed = std::min(maxOnScreen, toDestroy);
+    if (this->m_stress.shipCap > 0) {
+        allowed = this->m_stress.shipCap;
+    }
     int onScreen = 0;
     for (auto& obj: this->m_data) {
         if (obj->GetType() == GameObject::ObjectType::TypeAlphaShip \
@@ -75,36 +131,27 @@ LevelStatus GameWorld::Update() {
         int p3 = 3 * std::max(level - 2, 0);
         int r = randInt(1, p1 + p2 + p3);
         if (r <= p1) {
-            this->m_data.push_back(std::make_unique<AlphaShip>(
-                IMGID_ALPHATRON, // image id
+            this->AddObject(std::make_unique<AlphaShip>(
                 x, y, // x, y
                 180, // direction
-                0, // layer
                 1.0, // size
-                *this, // game world
                 20 + 2 * level, // health
                 4 + level, // damage
                 2 + level / 5 // speed                
             ));
         } else if (r <= p1 + p2) {
-            this->m_data.push_back(std::make_unique<SigmaShip>(
-                IMGID_SIGMATRON, // image id
+            this->AddObject(std::make_unique<SigmaShip>(
                 x, y, // x, y
                 180, // direction
-                0, // layer
                 1.0, // size
-                *this, // game world
                 25 + 5 * level, // health
                 2 + level / 5 // speed
             ));
         } else if (r <= p1 + p2 + p3) {
-            this->m_data.push_back(std::make_unique<OmegaShip>(
-                IMGID_OMEGATRON, // image id
+            this->AddObject(std::make_unique<OmegaShip>(
                 x, y, // x, y
                 180, // direction
-                0, // layer
                 1.0, // size
-                *this, // game world
                 20 + level, // health
                 2 + 2 * level, // damage
                 3 + level / 4 // speed
@@ -112,43 +159,113 @@ LevelStatus GameWorld::Update() {
         }
     }
 
+    perf.End(PerfCounters::Phase::SPAWN, this->m_data.size());
+    trace.End("world", "Spawn");
+
     // Update all objects
+    trace.Begin("world", "UpdateObjects");
+    perf.Begin(PerfCounters::Phase::OBJECTS);
+    this->FlushSpawned();
+    this->RecordStarts();
     this->m_player->Update();
-    for (const std::unique_ptr<GameObject>& obj : this->m_data) {
-        obj->Update();
+    this->FlushSpawned();
+    for (size_t i = 0; i < this->m_data.size(); i++) {
+        this->m_data[i]->Update();
+        this->FlushSpawned();
     } 
+    perf.End(PerfCounters::Phase::OBJECTS, this->m_data.size() + 1);
+    trace.End("world", "UpdateObjects");
+    trace.Begin("world", "UpdateParticles");
+    perf.Begin(PerfCounters::Phase::PARTICLES);
+    this->m_particles.Update();
+    perf.End(PerfCounters::Phase::PARTICLES, this->m_particles.GetCount());
+    trace.End("world", "UpdateParticles");
+    if (telemetry.IsEnabled()) {
+        this->RecordTick();
+    }
+
+    // Stress mode keeps the level running forever
+    if (this->m_stress.enabled) {
+        this->m_player->SetHealth(100);
+    }
 
     // Check if player is dead
     if (this->m_player->GetIsDead()) {
         this->m_life--;
+        trace.Instant("level", "DAWNBREAKER_DESTROYED");
+        telemetry.Emit(Telemetry::Kind::LEVEL_END, this->m_tick, this->GetLevel(), this->m_tick, 
+            static_cast<int>(LevelStatus::DAWNBREAKER_DESTROYED));
         return LevelStatus::DAWNBREAKER_DESTROYED;
     }
 
     // Check if level is completed
-    if (this->m_player->GetDestroyed() >= required) {
+    if (!this->m_stress.enabled && this->m_player->GetDestroyed() >= required) {
+        trace.Instant("level", "LEVEL_CLEARED");
+        telemetry.Emit(Telemetry::Kind::LEVEL_END, this->m_tick, this->GetLevel(), this->m_tick, 
+            static_cast<int>(LevelStatus::LEVEL_CLEARED));
         return LevelStatus::LEVEL_CLEARED;
     }
 
     // Delete all destroyed objects
-    this->m_data.remove_if([&](const std::unique_ptr<GameObject>& obj) {
-        return obj->GetIsDead();
-    });
+    trace.Begin("world", "CompactDead");
+    perf.Begin(PerfCounters::Phase::COMPACT);
+    size_t dead = this->m_dead.size();
+    this->CompactDead();
+    perf.End(PerfCounters::Phase::COMPACT, dead);
+    trace.End("world", "CompactDead");
 
     // Show message
+    trace.Begin("world", "StatusBar");
+    if (!this->m_governor.IsOn(FrameGovernor::Step::LAZY_STATUS_BAR) 
+            || this->m_tick % FrameGovernor::STATUS_BAR_TICKS == 0) {
+        this->UpdateStatusBar();
+    }
+    trace.End("world", "StatusBar");
+
+    if (this->m_governor.EndTick(this->m_tick)) {
+        this->ApplyGovernor();
+    }
+    perf.End(PerfCounters::Phase::TICK, this->m_data.size() + this->m_particles.GetCount() + 1);
+    return LevelStatus::ONGOING;
+}
+
+void GameWorld::RecordTick() const {
+    std::array<int, GameObject::TYPE_COUNT> counts{};
+    counts[GameObject::ObjectType::TypePlayer]++;
+    for (auto& obj: this->m_data) {
+        if (!obj->GetIsDead()) {
+            counts[obj->GetType()]++;
+        }
+    }
+    Telemetry& telemetry = Telemetry::Instance();
+    int objects = 0;
+    for (int type = 0; type < GameObject::TYPE_COUNT; type++) {
+        if (counts[type] > 0) {
+            telemetry.Emit(Telemetry::Kind::OBJECTS, this->m_tick, type, counts[type]);
+        }
+        objects += counts[type];
+    }
+    telemetry.Emit(Telemetry::Kind::TICK, this->m_tick, 0, objects, 
+        static_cast<int>(this->m_particles.GetCount()));
+}
+
+void GameWorld::UpdateStatusBar() {
     std::stringstream message;
     message << "HP: " << this->m_player->GetHealth() << "/100   Meteors: " \
         << this->m_player->GetMeteor() << "   Lives: " << this->m_life \
         << "   Level: " << this->GetLevel() \
-        << "   Enemies: " << this->m_player->GetDestroyed() << "/" << required \
+        << "   Enemies: " << this->m_player->GetDestroyed() << "/" << 3 * this->GetLevel() \
         << "   Score: " << this->GetScore();
     this->SetStatusBarMessage(message.str());
-
-    return LevelStatus::ONGOING;
 }
 
 void GameWorld::CleanUp() {
+    WorldBase::Scope scope(*this);
     this->m_player = nullptr;
     this->m_data.clear();
+    this->m_spawned.clear();
+    this->m_dead.clear();
+    this->m_particles.Clear();
 }
 
 
@@ -161,10 +278,281 @@ bool GameWorld::IsGameOver() const {
 /////////////////////////////////GameWorld////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 void GameWorld::AddObject(std::unique_ptr<GameObject> obj) {
-    this->m_data.push_back(std::move(obj));
+    this->m_spawned.push_back(std::move(obj));
 }
 
 
-std::list<std::unique_ptr<GameObject>>& GameWorld::GetObjects() {
+ObjectStore& GameWorld::GetObjects() {
     return this->m_data;
+}
+
+
+ParticleSystem& GameWorld::GetParticles() {
+    return this->m_particles;
+}
+
+
+ObjectPool& GameWorld::GetObjectPool() {
+    return this->m_pool;
+}
+
+
+void GameWorld::OnObjectDead(GameObject& obj) {
+    TraceRecorder::Instance().Instant("object", "death", GameObject::TypeName(obj.GetType()));
+    this->m_dead.push_back(&obj);
+}
+
+
+void GameWorld::FlushSpawned() {
+    if (this->m_spawned.empty()) {
+        return;
+    }
+    TraceRecorder& trace = TraceRecorder::Instance();
+    for (std::unique_ptr<GameObject>& obj : this->m_spawned) {
+        trace.Instant("object", "spawn", GameObject::TypeName(obj->GetType()));
+        obj->m_cold.slot = static_cast<int>(this->m_data.size());
+        this->m_starts.resize(this->m_data.size() + 1);
+        this->m_starts.back() = Position{ static_cast<int16_t>(obj->GetX()), static_cast<int16_t>(obj->GetY()) };
+        this->m_data.push_back(std::move(obj));
+    }
+    this->m_spawned.clear();
+}
+
+
+void GameWorld::RecordStarts() {
+    this->m_playerStart = Position{ static_cast<int16_t>(this->m_player->GetX()), 
+        static_cast<int16_t>(this->m_player->GetY()) };
+    this->m_starts.resize(this->m_data.size());
+    for (size_t i = 0; i < this->m_data.size(); i++) {
+        this->m_starts[i] = Position{ static_cast<int16_t>(this->m_data[i]->GetX()), 
+            static_cast<int16_t>(this->m_data[i]->GetY()) };
+    }
+}
+
+
+GameWorld::Position GameWorld::GetStart(const GameObject& obj) const {
+    int slot = obj.m_cold.slot;
+    if (slot < 0 || static_cast<size_t>(slot) >= this->m_starts.size()) {
+        // The player, or an object that is not part of the store yet
+        return &obj == this->m_player.get() ? this->m_playerStart
+            : Position{ static_cast<int16_t>(obj.GetX()), static_cast<int16_t>(obj.GetY()) };
+    }
+    return this->m_starts[slot];
+}
+
+
+bool GameWorld::UpdatesBefore(const GameObject& a, const GameObject& b) const {
+    if (&b == this->m_player.get()) {
+        return false;
+    }
+    return &a == this->m_player.get() || a.m_cold.slot < b.m_cold.slot;
+}
+
+
+void GameWorld::CompactDead() {
+    // Objects that died before joining the store get their slot first, so
+    // every queued object but the player has one.
+    this->FlushSpawned();
+    // Only the objects that died are visited: each one is swapped with the
+    // last object of the store and popped, which hands its storage back to
+    // the ObjectPool.
+    for (GameObject* obj : this->m_dead) {
+        if (obj == this->m_player.get()) {
+            continue; // not part of the store
+        }
+        int slot = obj->m_cold.slot;
+        int last = static_cast<int>(this->m_data.size()) - 1;
+        if (slot != last) {
+            std::swap(this->m_data[slot], this->m_data[last]);
+            this->m_data[slot]->m_cold.slot = slot;
+        }
+        this->m_data.pop_back();
+    }
+    this->m_dead.clear();
+}
+
+
+int GameWorld::GetLives() const {
+    return this->m_life;
+}
+
+
+void GameWorld::SetLives(int lives) {
+    this->m_life = lives;
+}
+
+
+int GameWorld::GetTick() const {
+    return this->m_tick;
+}
+
+
+void GameWorld::SetStressConfig(const StressConfig& config) {
+    this->m_stress = config;
+    if (config.starsPerTick > 0) {
+        // Every star lives for a screen height of ticks
+        this->m_particles.SetCapacity(
+            std::max<size_t>(ParticleSystem::DEFAULT_STARS, 
+                static_cast<size_t>(config.starsPerTick) * (WINDOW_HEIGHT + 2)), 
+            std::max<size_t>(ParticleSystem::DEFAULT_EXPLOSIONS, 
+                static_cast<size_t>(config.shipCap) * 20));
+    }
+}
+
+
+const StressConfig& GameWorld::GetStressConfig() const {
+    return this->m_stress;
+}
+
+
+void GameWorld::SetFrameBudget(double ms) {
+    this->m_governor.SetBudget(ms);
+    this->ApplyGovernor();
+}
+
+
+const FrameGovernor& GameWorld::GetGovernor() const {
+    return this->m_governor;
+}
+
+
+void GameWorld::ApplyGovernor() {
+    this->m_particles.SetExplosionTicks(
+        this->m_governor.IsOn(FrameGovernor::Step::SHORT_EXPLOSIONS) 
+            ? FrameGovernor::SHORT_EXPLOSION_TICKS : ParticleSystem::EXPLOSION_TICKS);
+    this->m_particles.SetLimit(
+        this->m_governor.IsOn(FrameGovernor::Step::PARTICLE_CAP) ? FrameGovernor::PARTICLE_CAP : 0);
+}
+
+
+void GameWorld::SaveSnapshot(Snapshot& snapshot) const {
+    // Objects save their countdowns relative to this world's tick.
+    WorldBase::Scope scope(const_cast<GameWorld&>(*this));
+    snapshot.clear();
+    SnapshotWriter out(snapshot);
+    out.Write<unsigned int>(SNAPSHOT_MAGIC);
+    out.Write<unsigned short>(SNAPSHOT_VERSION);
+
+    out.Write<int>(this->GetLevel());
+    out.Write<int>(this->GetScore());
+    out.Write<int>(this->m_life);
+    out.Write<int>(this->m_tick);
+    out.Write<unsigned long long>(this->GetContext().random.GetState());
+
+    out.Write<unsigned char>(this->m_player != nullptr);
+    if (this->m_player != nullptr) {
+        this->m_player->Save(out);
+    }
+
+    unsigned int counts[GameObject::TYPE_COUNT] = { };
+    for (const std::unique_ptr<GameObject>& obj : this->m_data) {
+        counts[obj->GetType()]++;
+    }
+    for (unsigned int count : counts) {
+        out.Write<unsigned int>(count);
+    }
+    for (const std::unique_ptr<GameObject>& obj : this->m_data) {
+        out.Write<unsigned char>(static_cast<unsigned char>(obj->GetType()));
+        obj->Save(out);
+    }
+
+    this->m_particles.Save(out);
+}
+
+
+bool GameWorld::RestoreSnapshot(const Snapshot& snapshot, bool keepProgress) {
+    WorldBase::Scope scope(*this);
+    SnapshotReader in(snapshot);
+    if (in.Read<unsigned int>() != SNAPSHOT_MAGIC 
+            || in.Read<unsigned short>() != SNAPSHOT_VERSION) {
+        return false;
+    }
+    int level = in.Read<int>();
+    int score = in.Read<int>();
+    int life = in.Read<int>();
+    int tick = in.Read<int>();
+    unsigned long long rng = in.Read<unsigned long long>();
+
+    std::unique_ptr<Player> player;
+    if (in.Read<unsigned char>()) {
+        player.reset(static_cast<Player*>(
+            GameObject::Create(GameObject::TypePlayer).release()));
+        player->Load(in);
+    }
+
+    // Carve storage for every object up front, then construct into it
+    size_t total = 0;
+    for (int type = 0; type < GameObject::TYPE_COUNT; type++) {
+        unsigned int count = in.Read<unsigned int>();
+        this->m_pool.Reserve(
+            GameObject::SizeOf(static_cast<GameObject::ObjectType>(type)), count);
+        total += count;
+    }
+    if (!in.IsGood()) {
+        return false;
+    }
+    ObjectStore objects;
+    objects.reserve(total);
+    for (size_t i = 0; i < total; i++) {
+        int type = in.Read<unsigned char>();
+        if (type <= GameObject::TypePlayer || type >= GameObject::TYPE_COUNT) {
+            return false;
+        }
+        objects.push_back(GameObject::Create(static_cast<GameObject::ObjectType>(type)));
+        objects.back()->Load(in);
+        if (objects.back()->GetIsDead()) {
+            objects.pop_back(); // died in the tick the snapshot was taken
+        }
+    }
+    ParticleSystem::State particles;
+    if (!ParticleSystem::Load(in, particles) || !in.AtEnd()) {
+        return false;
+    }
+
+    this->CleanUp();
+    this->m_tick = tick;
+    if (!keepProgress) {
+        this->SetLevel(level);
+        this->SetScore(score);
+        this->m_life = life;
+        this->GetContext().random.SetState(rng);
+    }
+    this->m_player = std::move(player);
+    this->m_data.swap(objects);
+    this->m_particles.Restore(particles);
+    for (size_t i = 0; i < this->m_data.size(); i++) {
+        this->m_data[i]->m_cold.slot = static_cast<int>(i);
+        this->m_data[i]->Resume();
+    }
+    if (this->m_player != nullptr) {
+        this->m_player->Resume();
+    }
+    return true;
+}
+
+
+void GameWorld::SaveState(SavedState& state) const {
+    this->SaveSnapshot(state.world);
+    state.levelStart.assign(this->m_levelStart.begin(), this->m_levelStart.end());
+    state.levelStartLevel = this->m_levelStartLevel;
+}
+
+
+bool GameWorld::RestoreState(const SavedState& state) {
+    if (!this->RestoreSnapshot(state.world)) {
+        return false;
+    }
+    this->m_levelStart.assign(state.levelStart.begin(), state.levelStart.end());
+    this->m_levelStartLevel = state.levelStartLevel;
+    return true;
+}
+
+
+void GameWorld::SetCheckpointFile(const std::string& path) {
+    this->m_checkpointFile = path;
+}
+
+
+bool GameWorld::LoadCheckpointFile(const std::string& path) {
+    return ReadSnapshotFile(path, this->m_pendingRestore);
 }
\ No newline at end of file
@@ -1,36 +1,150 @@
 #ifndef GAMEWORLD_H__
 #define GAMEWORLD_H__
 
-#include <list>
+#include <vector>
 
+#include "FrameGovernor.h"
 #include "GameObjects.h"
+#include "ObjectPool.h"
+#include "ParticleSystem.h"
 #include "WorldBase.h"
+#include "WorldSnapshot.h"
+#include "MemoryTracker.h"
 
 class GameObject;
 class Player;
 
+struct WorldStoreMemTag {
+    static int Id() { static int id = MemoryTracker::Instance().RegisterTag("world store"); return id; }
+};
+
+template<typename T>
+using WorldVector = std::vector<T, TrackingAllocator<T, WorldStoreMemTag>>;
+using ObjectStore = WorldVector<std::unique_ptr<GameObject>>;
+
+// Overrides for the spawn and fire limits so the world can be pushed to
+// thousands of live objects. A value of 0 keeps the normal game rule.
+// Stress mode is endless: levels never clear and the Dawnbreaker cannot die.
+struct StressConfig {
+    bool enabled = false;
+    int shipCap = 0;            // ships on screen, instead of (5 + level) / 2
+    int fireInterval = 0;       // ticks between player shots, instead of 10 energy
+    bool autoFire = false;      // fire without FIRE1 being held
+    int starsPerTick = 0;       // stars spawned per tick, instead of a 1/30 chance
+    int enemyFireInterval = 0;  // an enemy fires with 1/N chance per tick
+};
+
 class GameWorld : public WorldBase {
 
 public:
 
     GameWorld();
-    virtual ~GameWorld() = default;
+    virtual ~GameWorld();
 
     virtual void Init() override;
     virtual LevelStatus Update() override;
     virtual void CleanUp() override;
     virtual bool IsGameOver() const override;
 
+    // Objects added while the world is updating join the store once the
+    // current object's Update() returns, so iterating GetObjects() from
+    // inside an Update() is always safe.
     void AddObject(std::unique_ptr<GameObject>);
-    std::list<std::unique_ptr<GameObject>>& GetObjects();
+    ObjectStore& GetObjects();
+    // Stars and explosions.
+    ParticleSystem& GetParticles();
+    // Storage of this world's objects.
+    ObjectPool& GetObjectPool();
+
+    // Called by GameObject the first time it dies.
+    void OnObjectDead(GameObject&);
+
+    struct Position {
+        int16_t x;
+        int16_t y;
+    };
+    // Where an object was when the updates of the current tick began, or
+    // where it joined the store if it spawned during them.
+    Position GetStart(const GameObject&) const;
+    // Whether a's Update() runs before b's in a tick: the player's first,
+    // then the store's in slot order. A pair of movers is hit-tested once
+    // per tick, by the one that updates last, when both have moved.
+    bool UpdatesBefore(const GameObject& a, const GameObject& b) const;
+
+    int GetLives() const;
+    void SetLives(int);
+
+    // Ticks simulated since the level was initialized.
+    int GetTick() const;
+
+    // Formats health, meteors, lives, level progress and score into the
+    // status bar. Called at the end of every ongoing tick.
+    void UpdateStatusBar();
+
+    void SetStressConfig(const StressConfig&);
+    const StressConfig& GetStressConfig() const;
+
+    // Milliseconds an ongoing tick may take before the FrameGovernor starts
+    // giving up cosmetic work; 0, the default, turns it off. Never set on a
+    // VersusWorld: the governor follows wall-clock tick times, rollbacks
+    // included, so the peers' worlds would no longer hash the same.
+    void SetFrameBudget(double ms);
+    const FrameGovernor& GetGovernor() const;
+
+    // Captures progress, RNG state, the player, every object and particle.
+    void SaveSnapshot(Snapshot&) const;
+    // Replaces the world with a snapshot, leaving it untouched on failure.
+    // With keepProgress the running level, score, lives and RNG are kept.
+    bool RestoreSnapshot(const Snapshot&, bool keepProgress = false);
+
+    // A snapshot plus the level start that Init() retries from, so a world
+    // can be rolled back across level transitions.
+    struct SavedState {
+        Snapshot world;
+        Snapshot levelStart;
+        int levelStartLevel = 0;
+    };
+    void SaveState(SavedState&) const;
+    bool RestoreState(const SavedState&);
+
+    // Writes a crash checkpoint every time a level starts.
+    void SetCheckpointFile(const std::string&);
+    // Makes the next Init() resume from a checkpoint written earlier.
+    bool LoadCheckpointFile(const std::string&);
 
 
     std::unique_ptr<Player> m_player;
 
 private:
 
+    ObjectPool m_pool;
+
+    void FlushSpawned();
+    void CompactDead();
+    // Records where every object starts the tick.
+    void RecordStarts();
+    // Object counts by type for the telemetry stream.
+    void RecordTick() const;
+    // Sets the particle system up for the governor steps turned on.
+    void ApplyGovernor();
+
     int m_life;    
-    std::list<std::unique_ptr<GameObject>> m_data;
+    int m_tick;
+    StressConfig m_stress;
+    ObjectStore m_data;
+    ObjectStore m_spawned;
+    // By store slot.
+    WorldVector<Position> m_starts;
+    Position m_playerStart;
+    WorldVector<GameObject*> m_dead;
+    ParticleSystem m_particles;
+    FrameGovernor m_governor;
+
+    // Level-start state, restored instead of rebuilt when a level is retried.
+    Snapshot m_levelStart;
+    int m_levelStartLevel;
+    Snapshot m_pendingRestore;
+    std::string m_checkpointFile;
 
 };
 
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <new>
+
+#include "ObjectPool.h"
+
+ObjectPool::ObjectPool(GameWorld& world): m_world(&world), m_free(), m_freeCount(), m_chunks(),
+    m_chunkBytes(0), m_counts() { }
+
+ObjectPool::~ObjectPool() {
+    for (unsigned char* chunk : this->m_chunks) {
+        ::operator delete(chunk, std::align_val_t(CHUNK_BYTES));
+    }
+    MemoryTracker::Instance().Deallocate(PoolMemTag::Id(), this->m_chunkBytes);
+}
+
+void* ObjectPool::Allocate(std::size_t size) {
+    if (size > MAX_BLOCK) {
+        // A chunk of its own, so Of() still finds the pool.
+        MemoryTracker::Instance().Allocate(PoolMemTag::Id(), GRANULARITY + size);
+        return this->NewChunk(GRANULARITY + size) + GRANULARITY;
+    }
+    std::size_t sizeClass = (size + GRANULARITY - 1) / GRANULARITY;
+    if (this->m_free[sizeClass] == nullptr) {
+        this->Refill(sizeClass, 1);
+    }
+    FreeBlock* block = this->m_free[sizeClass];
+    this->m_free[sizeClass] = block->next;
+    this->m_freeCount[sizeClass]--;
+    return block;
+}
+
+void ObjectPool::Deallocate(void* block, std::size_t size) {
+    if (block == nullptr) {
+        return;
+    }
+    if (size > MAX_BLOCK) {
+        MemoryTracker::Instance().Deallocate(PoolMemTag::Id(), GRANULARITY + size);
+        ::operator delete(static_cast<unsigned char*>(block) - GRANULARITY, std::align_val_t(CHUNK_BYTES));
+        return;
+    }
+    std::size_t sizeClass = (size + GRANULARITY - 1) / GRANULARITY;
+    FreeBlock* freed = static_cast<FreeBlock*>(block);
+    freed->next = this->m_free[sizeClass];
+    this->m_free[sizeClass] = freed;
+    this->m_freeCount[sizeClass]++;
+}
+
+void ObjectPool::Reserve(std::size_t size, std::size_t count) {
+    if (size > MAX_BLOCK || size == 0) {
+        return;
+    }
+    std::size_t sizeClass = (size + GRANULARITY - 1) / GRANULARITY;
+    if (this->m_freeCount[sizeClass] < count) {
+        this->Refill(sizeClass, count - this->m_freeCount[sizeClass]);
+    }
+}
+
+GameWorld& ObjectPool::GetWorld() const {
+    return *this->m_world;
+}
+
+MemoryTracker::LocalCounts& ObjectPool::GetCounts() {
+    return this->m_counts;
+}
+
+unsigned char* ObjectPool::NewChunk(std::size_t bytes) {
+    unsigned char* chunk = static_cast<unsigned char*>(::operator new(bytes, std::align_val_t(CHUNK_BYTES)));
+    new (chunk) ChunkHeader{ this };
+    return chunk;
+}
+
+void ObjectPool::Refill(std::size_t sizeClass, std::size_t blocks) {
+    std::size_t blockSize = sizeClass * GRANULARITY;
+    std::size_t blocksPerChunk = (CHUNK_BYTES - GRANULARITY) / blockSize;
+    while (blocks > 0) {
+        unsigned char* chunk = this->NewChunk(CHUNK_BYTES);
+        this->m_chunks.push_back(chunk);
+        MemoryTracker::Instance().Allocate(PoolMemTag::Id(), CHUNK_BYTES);
+        this->m_chunkBytes += CHUNK_BYTES;
+        for (std::size_t i = blocksPerChunk; i > 0; i--) {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + GRANULARITY + (i - 1) * blockSize);
+            block->next = this->m_free[sizeClass];
+            this->m_free[sizeClass] = block;
+        }
+        this->m_freeCount[sizeClass] += blocksPerChunk;
+        blocks -= std::min(blocks, blocksPerChunk);
+    }
+}
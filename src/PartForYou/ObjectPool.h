@@ -0,0 +1,82 @@
+#ifndef OBJECTPOOL_H__
+#define OBJECTPOOL_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MemoryTracker.h"
+
+class GameWorld;
+
+// Recycles GameObject storage.
+// Blocks are grouped in 16-byte size classes and carved out of chunks, so
+// once the pool has warmed up spawning and destroying objects never touches
+// the heap. Every GameWorld owns a pool; chunks are kept until the world goes
+// away and are accounted as "object pool", the objects living in them are
+// counted per ObjectType in the pool's own MemoryTracker::LocalCounts.
+//
+// Chunks are aligned to their size and start with a pointer back to the
+// pool, so Of() finds the pool, and through it the world, of any block
+// without a thread-local current world.
+class ObjectPool {
+
+public:
+
+    explicit ObjectPool(GameWorld& world);
+    ~ObjectPool();
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    void* Allocate(std::size_t size);
+    void Deallocate(void* block, std::size_t size);
+
+    // Makes sure count blocks of the given size are free, carving them out
+    // of as few chunks as possible.
+    void Reserve(std::size_t size, std::size_t count);
+
+    // The pool a block returned by Allocate() came from.
+    static ObjectPool& Of(const void* block) {
+        uintptr_t chunk = reinterpret_cast<uintptr_t>(block) & ~static_cast<uintptr_t>(CHUNK_BYTES - 1);
+        return *reinterpret_cast<const ChunkHeader*>(chunk)->pool;
+    }
+
+    GameWorld& GetWorld() const;
+    // Live objects by type, added up by MemoryTracker when it reports.
+    MemoryTracker::LocalCounts& GetCounts();
+
+private:
+
+    static const std::size_t GRANULARITY = 16;
+    static const std::size_t MAX_BLOCK = 256;
+    static const std::size_t CHUNK_BYTES = 4096;
+
+    // Takes the first GRANULARITY bytes of every chunk.
+    struct ChunkHeader {
+        ObjectPool* pool;
+    };
+    static_assert(sizeof(ChunkHeader) <= GRANULARITY, "chunk header outgrew its block");
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct PoolMemTag {
+        static int Id() { static int id = MemoryTracker::Instance().RegisterTag("object pool"); return id; }
+    };
+
+    // A CHUNK_BYTES-aligned chunk of at least bytes, header filled in.
+    unsigned char* NewChunk(std::size_t bytes);
+    void Refill(std::size_t sizeClass, std::size_t blocks);
+
+    GameWorld* m_world;
+    std::array<FreeBlock*, MAX_BLOCK / GRANULARITY + 1> m_free;
+    std::array<std::size_t, MAX_BLOCK / GRANULARITY + 1> m_freeCount;
+    std::vector<unsigned char*> m_chunks;
+    std::size_t m_chunkBytes;
+    MemoryTracker::LocalCounts m_counts;
+
+};
+
+#endif // !OBJECTPOOL_H__
@@ -0,0 +1,162 @@
+#include "ParticleSystem.h"
+
+#include <algorithm>
+
+static const float EXPLOSION_SIZE = 4.5f;
+static const float EXPLOSION_SHRINK = 0.2f;
+// Star heights stay exact in a float while they are below 2^24; the scroll
+// is taken out of them well before.
+static const float STAR_RESCROLL = 1 << 20;
+
+ParticleSystem::ParticleSystem(RenderRegistry& registry): 
+    m_stars(registry, IMGID_STAR, 4, DEFAULT_STARS), 
+    m_explosions(registry, IMGID_EXPLOSION, 3, DEFAULT_EXPLOSIONS), 
+    m_explosionAge(DEFAULT_EXPLOSIONS), m_explosionTicks(EXPLOSION_TICKS), m_limit(0) { }
+
+void ParticleSystem::SpawnStar(int x, int y, double size) {
+    if (this->m_limit > 0 && this->GetCount() >= this->m_limit) {
+        return;
+    }
+    this->AddStar(static_cast<float>(x), static_cast<float>(y), static_cast<float>(size));
+}
+
+void ParticleSystem::AddStar(float x, float y, float size) {
+    // After the stars that leave the screen no later than this one
+    float height = y + this->GetStarScroll();
+    const float* heights = this->m_stars.GetY();
+    size_t count = this->m_stars.GetCount();
+    size_t i = std::upper_bound(heights, heights + count, height) - heights;
+    this->m_stars.Insert(i, x, height, size);
+}
+
+float ParticleSystem::GetStarScroll() const {
+    return -this->m_stars.GetOffsetY();
+}
+
+void ParticleSystem::SpawnExplosion(int x, int y) {
+    if (this->m_limit > 0 && this->GetCount() >= this->m_limit) {
+        return;
+    }
+    int i = this->m_explosions.Add(static_cast<float>(x), static_cast<float>(y), EXPLOSION_SIZE);
+    if (i >= 0) {
+        this->m_explosionAge[i] = 0;
+    }
+}
+
+void ParticleSystem::Update() {
+    // Stars: the ones below the screen are the first ones; every other one
+    // moves down by moving the batch
+    float scroll = this->GetStarScroll();
+    float* heights = this->m_stars.GetY();
+    size_t count = this->m_stars.GetCount();
+    size_t gone = std::lower_bound(heights, heights + count, scroll) - heights;
+    this->m_stars.RemoveFront(gone);
+    scroll += 1;
+    if (scroll >= STAR_RESCROLL) {
+        heights = this->m_stars.GetY();
+        for (size_t i = 0; i < this->m_stars.GetCount(); i++) {
+            heights[i] -= scroll;
+        }
+        scroll = 0;
+    }
+    this->m_stars.SetOffset(0.0f, -scroll);
+
+    // Explosions: shrink, and finish after m_explosionTicks updates
+    float* size = this->m_explosions.GetSize();
+    for (size_t i = 0; i < this->m_explosions.GetCount(); ) {
+        size[i] -= EXPLOSION_SHRINK;
+        if (++this->m_explosionAge[i] >= this->m_explosionTicks) {
+            size_t last = this->m_explosions.GetCount() - 1;
+            this->m_explosionAge[i] = this->m_explosionAge[last];
+            this->m_explosions.Remove(i);
+        } else {
+            i++;
+        }
+    }
+}
+
+void ParticleSystem::Clear() {
+    this->m_stars.Clear();
+    this->m_stars.SetOffset(0.0f, 0.0f);
+    this->m_explosions.Clear();
+}
+
+void ParticleSystem::SetCapacity(size_t stars, size_t explosions) {
+    this->m_stars.SetCapacity(stars);
+    this->m_stars.SetOffset(0.0f, 0.0f);
+    this->m_explosions.SetCapacity(explosions);
+    this->m_explosionAge.assign(explosions, 0);
+}
+
+void ParticleSystem::SetExplosionTicks(int ticks) {
+    this->m_explosionTicks = ticks;
+}
+
+void ParticleSystem::SetLimit(size_t particles) {
+    this->m_limit = particles;
+}
+
+size_t ParticleSystem::GetStarCount() const {
+    return this->m_stars.GetCount();
+}
+
+size_t ParticleSystem::GetExplosionCount() const {
+    return this->m_explosions.GetCount();
+}
+
+size_t ParticleSystem::GetCount() const {
+    return this->m_stars.GetCount() + this->m_explosions.GetCount();
+}
+
+void ParticleSystem::Save(SnapshotWriter& out) const {
+    out.Write<unsigned int>(static_cast<unsigned int>(this->m_stars.GetCount()));
+    for (size_t i = 0; i < this->m_stars.GetCount(); i++) {
+        out.Write<float>(this->m_stars.GetX()[i]);
+        out.Write<float>(this->m_stars.GetY()[i] - this->GetStarScroll());
+        out.Write<float>(this->m_stars.GetSize()[i]);
+    }
+    out.Write<unsigned int>(static_cast<unsigned int>(this->m_explosions.GetCount()));
+    for (size_t i = 0; i < this->m_explosions.GetCount(); i++) {
+        out.Write<float>(this->m_explosions.GetX()[i]);
+        out.Write<float>(this->m_explosions.GetY()[i]);
+        out.Write<float>(this->m_explosions.GetSize()[i]);
+        out.Write<unsigned char>(this->m_explosionAge[i]);
+    }
+}
+
+bool ParticleSystem::Load(SnapshotReader& in, State& state) {
+    state.stars.clear();
+    state.explosions.clear();
+    unsigned int stars = in.Read<unsigned int>();
+    for (unsigned int i = 0; i < stars && in.IsGood(); i++) {
+        Particle p;
+        p.x = in.Read<float>();
+        p.y = in.Read<float>();
+        p.size = in.Read<float>();
+        p.age = 0;
+        state.stars.push_back(p);
+    }
+    unsigned int explosions = in.Read<unsigned int>();
+    for (unsigned int i = 0; i < explosions && in.IsGood(); i++) {
+        Particle p;
+        p.x = in.Read<float>();
+        p.y = in.Read<float>();
+        p.size = in.Read<float>();
+        p.age = in.Read<unsigned char>();
+        state.explosions.push_back(p);
+    }
+    return in.IsGood();
+}
+
+void ParticleSystem::Restore(const State& state) {
+    this->Clear();
+    for (const Particle& p : state.stars) {
+        this->AddStar(p.x, p.y, p.size);
+    }
+    for (const Particle& p : state.explosions) {
+        int i = this->m_explosions.Add(p.x, p.y, p.size);
+        if (i >= 0) {
+            this->m_explosionAge[i] = p.age;
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef PARTICLESYSTEM_H__
+#define PARTICLESYSTEM_H__
+
+#include <cstdint>
+#include <vector>
+
+#include "ParticleBatch.h"
+#include "WorldSnapshot.h"
+
+// The starfield and explosions. They never collide, score or die early, so
+// instead of being GameObjects they live in two ParticleBatches. Spawns
+// beyond the capacity are dropped: particles are purely cosmetic.
+//
+// Stars all drift down at one pixel per tick, so none of them is written
+// while it drifts: each stores its height plus the scroll at the time, which
+// is also the scroll at which it leaves the screen, and the star batch is
+// drawn offset by the current scroll. Stars are kept sorted by that height,
+// so a tick only scrolls and drops the stars at the front whose time came.
+// Explosions are advanced by one loop each tick.
+class ParticleSystem {
+
+public:
+
+    struct Particle {
+        float x;
+        float y;
+        float size;
+        uint8_t age;
+    };
+    using ParticleList = std::vector<Particle, TrackingAllocator<Particle, ParticleMemTag>>;
+
+    // Particle state read from a snapshot, installed only once the rest of
+    // the snapshot turned out to be valid.
+    struct State {
+        ParticleList stars;
+        ParticleList explosions;
+    };
+
+    static constexpr size_t DEFAULT_STARS = 1024;
+    static constexpr size_t DEFAULT_EXPLOSIONS = 256;
+    static const int EXPLOSION_TICKS = 20;
+
+    explicit ParticleSystem(RenderRegistry&);
+
+    void SpawnStar(int x, int y, double size);
+    void SpawnExplosion(int x, int y);
+
+    // Stars drift down one pixel and leave below the screen, explosions
+    // shrink for EXPLOSION_TICKS. Costs a step per explosion but only per
+    // star that leaves.
+    void Update();
+    void Clear();
+    // Drops all particles.
+    void SetCapacity(size_t stars, size_t explosions);
+    // Ends explosions after the given number of ticks instead, the ones
+    // already older on the next update.
+    void SetExplosionTicks(int ticks);
+    // Drops spawns while there are this many particles or more, on top of
+    // the capacities; 0 lifts the limit.
+    void SetLimit(size_t particles);
+
+    size_t GetStarCount() const;
+    size_t GetExplosionCount() const;
+    size_t GetCount() const;
+
+    void Save(SnapshotWriter&) const;
+    static bool Load(SnapshotReader&, State&);
+    void Restore(const State&);
+
+private:
+
+    // Inserts a star at its drawn position.
+    void AddStar(float x, float y, float size);
+    // Pixels the stars drifted since they were last rebased.
+    float GetStarScroll() const;
+
+    ParticleBatch m_stars;
+    ParticleBatch m_explosions;
+    std::vector<uint8_t, TrackingAllocator<uint8_t, ParticleMemTag>> m_explosionAge;
+    int m_explosionTicks;
+    size_t m_limit;
+
+};
+
+#endif // !PARTICLESYSTEM_H__
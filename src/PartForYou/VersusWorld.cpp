@@ -0,0 +1,572 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include "VersusWorld.h"
+
+namespace {
+
+long long NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+VersusWorld::VersusWorld(Role role): m_role(role), m_rival(), m_localInput(), m_rivalInput(),
+    m_link(), m_port(47800), m_targetLevel(5), m_connected(false), m_abandoned(false),
+    m_frame(0), m_inputs(), m_confirmed(), m_used(), m_acked(INPUT_DELAY - 1),
+    m_rollbackTo(INT_MAX), m_match(), m_saved(), m_checks(), m_rivalChecks(), m_lastCheck(0),
+    m_lastHeardMs(0), m_stats() {
+    // Nobody presses anything during the first INPUT_DELAY frames.
+    this->m_confirmed.fill(INPUT_DELAY - 1);
+    this->m_checks.fill(Check(-1, 0));
+    this->m_rivalChecks.fill(Check(-1, 0));
+    this->SetInputSource(&this->m_localInput);
+    this->m_rival.SetInputSource(&this->m_rivalInput);
+}
+
+VersusWorld::~VersusWorld() { }
+
+void VersusWorld::SetLocalInput(InputSource* input) {
+    this->m_localInput.device = input;
+}
+
+void VersusWorld::SetPort(unsigned short port) {
+    this->m_port = port;
+}
+
+void VersusWorld::SetImpairment(int delayMs, int jitterMs, int lossPercent) {
+    this->m_link.SetImpairment(delayMs, jitterMs, lossPercent);
+}
+
+void VersusWorld::SetTargetLevel(int level) {
+    this->m_targetLevel = std::max(1, level);
+}
+
+GameWorld& VersusWorld::GetRival() {
+    return this->m_rival;
+}
+
+const VersusWorld::Stats& VersusWorld::GetStats() const {
+    return this->m_stats;
+}
+
+int VersusWorld::GetFrame() const {
+    return this->m_frame;
+}
+
+GameWorld& VersusWorld::Side(int side) {
+    return side == this->LocalSide() ? static_cast<GameWorld&>(*this) : this->m_rival;
+}
+
+const GameWorld& VersusWorld::Side(int side) const {
+    return side == this->LocalSide() ? static_cast<const GameWorld&>(*this) : this->m_rival;
+}
+
+int VersusWorld::LocalSide() const {
+    return this->m_role == Role::HOST ? 0 : 1;
+}
+
+int VersusWorld::RemoteSide() const {
+    return 1 - this->LocalSide();
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+////////////////////////////////Connection////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+void VersusWorld::Init() {
+    if (this->m_connected || this->m_abandoned) {
+        return;
+    }
+    unsigned long long seed = 0;
+    if (!this->Connect(seed)) {
+        this->m_abandoned = true;
+        return;
+    }
+    this->m_connected = true;
+    this->m_lastHeardMs = NowMs();
+
+    // Both worlds start from the same seed, so both players face the same
+    // enemies until attacks set them apart.
+    for (int side = 0; side < 2; side++) {
+        GameWorld& world = this->Side(side);
+        world.GetContext().random.SetState(seed);
+        world.SetLevel(1);
+        world.GameWorld::Init();
+    }
+}
+
+bool VersusWorld::Connect(unsigned long long& seed) {
+    bool host = this->m_role == Role::HOST;
+    unsigned short localPort = host ? this->m_port : this->m_port + 1;
+    unsigned short remotePort = host ? this->m_port + 1 : this->m_port;
+    if (!this->m_link.Open(localPort, remotePort)) {
+        return false;
+    }
+    std::cout << (host ? "Waiting for the guest on port " : "Joining the host on port ")
+        << this->m_port << std::endl;
+
+    if (host) {
+        seed = (static_cast<unsigned long long>(std::random_device()()) << 32)
+            | std::random_device()();
+    }
+    bool heard = false;
+    long long deadline = NowMs() + 60000;
+    long long nextSend = 0;
+    std::vector<unsigned char> datagram;
+    while (NowMs() < deadline) {
+        while (this->m_link.Receive(datagram)) {
+            Snapshot data(datagram.begin(), datagram.end());
+            SnapshotReader in(data);
+            PacketType type = static_cast<PacketType>(in.Read<unsigned char>());
+            if (host && type == HELLO) {
+                heard = true;
+            } else if (host && (type == START_ACK || type == INPUTS)) {
+                return true;
+            } else if (!host && type == START) {
+                seed = in.Read<unsigned long long>();
+                int target = in.Read<int>();
+                if (!in.IsGood()) {
+                    continue;
+                }
+                this->m_targetLevel = target;
+                this->SendPacket(START_ACK, Snapshot());
+                return true;
+            }
+        }
+        if (NowMs() >= nextSend) {
+            if (!host) {
+                this->SendPacket(HELLO, Snapshot());
+            } else if (heard) {
+                Snapshot payload;
+                SnapshotWriter out(payload);
+                out.Write<unsigned long long>(seed);
+                out.Write<int>(this->m_targetLevel);
+                this->SendPacket(START, payload);
+            }
+            nextSend = NowMs() + 100;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::cerr << "Nobody answered on port " << remotePort << std::endl;
+    return false;
+}
+
+void VersusWorld::SendPacket(PacketType type, const Snapshot& payload) {
+    unsigned char datagram[LocalLink::MAX_DATAGRAM];
+    size_t size = std::min(payload.size() + 1, sizeof(datagram));
+    datagram[0] = type;
+    std::copy(payload.begin(), payload.begin() + (size - 1), datagram + 1);
+    this->m_link.Send(datagram, size);
+}
+
+void VersusWorld::SendInputs() {
+    // Every datagram repeats all local input the rival has not acknowledged
+    // yet, so a lost datagram only costs time.
+    int local = this->LocalSide();
+    int first = this->m_acked + 1;
+    int count = std::max(0, this->m_confirmed[local] - first + 1);
+
+    Snapshot payload;
+    SnapshotWriter out(payload);
+    out.Write<int>(this->m_confirmed[this->RemoteSide()]);
+    out.Write<int>(first);
+    out.Write<unsigned char>(static_cast<unsigned char>(count));
+    for (int frame = first; frame < first + count; frame++) {
+        out.Write<unsigned char>(this->m_inputs[local][frame % INPUT_HISTORY]);
+    }
+    const Check& check = this->m_checks[(this->m_lastCheck / CHECK_INTERVAL) % this->m_checks.size()];
+    out.Write<int>(check.first);
+    out.Write<unsigned long long>(check.second);
+    this->SendPacket(INPUTS, payload);
+}
+
+void VersusWorld::Poll() {
+    int remote = this->RemoteSide();
+    std::vector<unsigned char> datagram;
+    while (this->m_link.Receive(datagram)) {
+        Snapshot data(datagram.begin(), datagram.end());
+        SnapshotReader in(data);
+        PacketType type = static_cast<PacketType>(in.Read<unsigned char>());
+        this->m_lastHeardMs = NowMs();
+        if (type == START && this->m_role == Role::GUEST) {
+            // The host missed our acknowledgement.
+            this->SendPacket(START_ACK, Snapshot());
+            continue;
+        }
+        if (type != INPUTS) {
+            continue;
+        }
+
+        int acked = in.Read<int>();
+        int first = in.Read<int>();
+        int count = in.Read<unsigned char>();
+        std::vector<unsigned char> inputs(count);
+        for (int i = 0; i < count; i++) {
+            inputs[i] = in.Read<unsigned char>();
+        }
+        Check check;
+        check.first = in.Read<int>();
+        check.second = in.Read<unsigned long long>();
+        if (!in.IsGood()) {
+            continue;
+        }
+
+        this->m_acked = std::max(this->m_acked, acked);
+        for (int i = 0; i < count; i++) {
+            int frame = first + i;
+            if (frame <= this->m_confirmed[remote]) {
+                continue;
+            }
+            if (frame != this->m_confirmed[remote] + 1
+                    || frame - this->m_frame >= INPUT_HISTORY / 2) {
+                break;
+            }
+            this->m_inputs[remote][frame % INPUT_HISTORY] = inputs[i];
+            this->m_confirmed[remote] = frame;
+            // A frame simulated on a wrong guess has to be simulated again
+            if (frame < this->m_frame && inputs[i] != this->m_used[frame % INPUT_HISTORY]) {
+                this->m_rollbackTo = std::min(this->m_rollbackTo, frame);
+            }
+        }
+
+        if (check.first > 0) {
+            this->m_rivalChecks[(check.first / CHECK_INTERVAL) % this->m_rivalChecks.size()] = check;
+            this->CompareChecks(check.first);
+        }
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+/////////////////////////////////Rollback/////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+LevelStatus VersusWorld::Update() {
+    if (!this->m_connected || this->m_abandoned) {
+        this->m_abandoned = true;
+        return LevelStatus::DAWNBREAKER_DESTROYED;
+    }
+
+    this->Poll();
+    if (this->m_rollbackTo < this->m_frame) {
+        this->RollBack(this->m_rollbackTo);
+    }
+    this->m_rollbackTo = INT_MAX;
+    this->UpdateChecks();
+
+    // The match is over once the frame that decided it is confirmed
+    if (this->m_match.decidedFrame >= 0
+            && this->m_match.decidedFrame <= this->m_confirmed[this->RemoteSide()]) {
+        static const char* const outcomes[] = { "ongoing", "you won", "you lost", "draw", "abandoned" };
+        std::cout << "Match over at frame " << this->m_match.decidedFrame << ": "
+            << outcomes[static_cast<int>(this->Decide())] << std::endl;
+        // Keep answering for a moment so the rival can confirm it too
+        for (int i = 0; i < 25; i++) {
+            this->Poll();
+            this->SendInputs();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        return LevelStatus::DAWNBREAKER_DESTROYED;
+    }
+    if (NowMs() - this->m_lastHeardMs > TIMEOUT_MS) {
+        std::cerr << "Lost the connection to the rival" << std::endl;
+        this->m_abandoned = true;
+        return LevelStatus::DAWNBREAKER_DESTROYED;
+    }
+
+    if (this->CanAdvance()) {
+        int local = this->LocalSide();
+        int inputFrame = this->m_frame + INPUT_DELAY;
+        this->m_inputs[local][inputFrame % INPUT_HISTORY] = this->SampleLocal();
+        this->m_confirmed[local] = inputFrame;
+        this->Simulate(this->m_frame);
+        this->m_frame++;
+        this->m_stats.frames++;
+    } else {
+        this->m_stats.stalls++;
+    }
+    this->SendInputs();
+    this->ShowStatus();
+    return LevelStatus::ONGOING;
+}
+
+bool VersusWorld::CanAdvance() const {
+    // Never guess further ahead than a rollback can undo, nor send more
+    // unacknowledged input than fits in one datagram.
+    return this->m_frame - this->m_confirmed[this->RemoteSide()] <= MAX_ROLLBACK
+        && this->m_frame + INPUT_DELAY - this->m_acked <= MAX_INPUTS_PER_PACKET;
+}
+
+unsigned char VersusWorld::InputBit(KeyCode key) {
+    switch (key) {
+    case KeyCode::UP:
+        return 1 << 0;
+    case KeyCode::LEFT:
+        return 1 << 1;
+    case KeyCode::DOWN:
+        return 1 << 2;
+    case KeyCode::RIGHT:
+        return 1 << 3;
+    case KeyCode::FIRE1:
+        return 1 << 4;
+    case KeyCode::FIRE2:
+        return 1 << 5;
+    default:
+        return 0;
+    }
+}
+
+unsigned char VersusWorld::SampleLocal() {
+    InputSource* device = this->m_localInput.device;
+    if (device == nullptr || this->m_match.decidedFrame >= 0) {
+        return 0;
+    }
+    unsigned char input = 0;
+    const KeyCode held[] = { KeyCode::UP, KeyCode::LEFT, KeyCode::DOWN, KeyCode::RIGHT, KeyCode::FIRE1 };
+    for (KeyCode key : held) {
+        if (device->GetKey(key)) {
+            input |= InputBit(key);
+        }
+    }
+    // A meteor is one press, not a held key
+    if (device->GetKeyDown(KeyCode::FIRE2)) {
+        input |= InputBit(KeyCode::FIRE2);
+    }
+    return input;
+}
+
+unsigned char VersusWorld::InputAt(int side, int frame) const {
+    if (frame < 0) {
+        return 0;
+    }
+    // Past the last known input the rival is assumed to keep doing the same
+    int known = std::min(frame, this->m_confirmed[side]);
+    return this->m_inputs[side][known % INPUT_HISTORY];
+}
+
+void VersusWorld::Simulate(int frame) {
+    SavedFrame& saved = this->m_saved[frame % STATE_HISTORY];
+    saved.frame = frame;
+    for (int side = 0; side < 2; side++) {
+        this->Side(side).SaveState(saved.worlds[side]);
+    }
+    saved.match = this->m_match;
+    this->m_used[frame % INPUT_HISTORY] = this->InputAt(this->RemoteSide(), frame);
+
+    // Once decided, the worlds stay as they ended
+    if (this->m_match.decidedFrame >= 0) {
+        return;
+    }
+    for (int side = 0; side < 2; side++) {
+        this->StepSide(side, frame);
+    }
+    for (int side = 0; side < 2; side++) {
+        if (this->m_match.finished[side] || this->m_match.lost[side]) {
+            this->m_match.decidedFrame = frame;
+        }
+    }
+}
+
+void VersusWorld::StepSide(int side, int frame) {
+    GameWorld& world = this->Side(side);
+    FrameInput& input = side == this->LocalSide() ? this->m_localInput : this->m_rivalInput;
+    input.current = this->InputAt(side, frame);
+    input.previous = this->InputAt(side, frame - 1);
+
+    // Attacks from the rival come in at the top of the screen
+    {
+        WorldBase::Scope scope(world);
+        int level = world.GetLevel();
+        for (; this->m_match.pendingAttacks[side] > 0; this->m_match.pendingAttacks[side]--) {
+            world.AddObject(std::make_unique<AlphaShip>(
+                randInt(0, WINDOW_WIDTH - 1), WINDOW_HEIGHT - 1, // x, y
+                180, // direction
+                1.0, // size
+                20 + 2 * level, // health
+                4 + level, // damage
+                2 + level / 5 // speed
+            ));
+        }
+    }
+
+    input.simulating = true;
+    LevelStatus status = world.GameWorld::Update();
+    input.simulating = false;
+
+    switch (status) {
+    case LevelStatus::ONGOING:
+        break;
+    case LevelStatus::LEVEL_CLEARED:
+        world.GameWorld::CleanUp();
+        if (world.GetLevel() >= this->m_targetLevel) {
+            this->m_match.finished[side] = true;
+        } else {
+            world.SetLevel(world.GetLevel() + 1);
+            world.GameWorld::Init();
+        }
+        break;
+    case LevelStatus::DAWNBREAKER_DESTROYED:
+        world.GameWorld::CleanUp();
+        if (world.GameWorld::IsGameOver()) {
+            this->m_match.lost[side] = true;
+        } else {
+            world.GameWorld::Init();
+        }
+        break;
+    }
+
+    int attacks = (world.GetScore() - this->m_match.creditedScore[side]) / ATTACK_SCORE;
+    this->m_match.creditedScore[side] += attacks * ATTACK_SCORE;
+    this->m_match.pendingAttacks[1 - side] += attacks;
+}
+
+void VersusWorld::RollBack(int frame) {
+    const SavedFrame& saved = this->m_saved[frame % STATE_HISTORY];
+    if (saved.frame != frame) {
+        // CanAdvance() keeps every frame that can be guessed wrong in reach
+        std::cerr << "Cannot roll back to frame " << frame << std::endl;
+        return;
+    }
+    int present = this->m_frame;
+    for (int side = 0; side < 2; side++) {
+        this->Side(side).RestoreState(saved.worlds[side]);
+    }
+    this->m_match = saved.match;
+    for (int f = frame; f < present; f++) {
+        this->Simulate(f);
+    }
+
+    this->m_stats.rollbacks++;
+    this->m_stats.resimulated += present - frame;
+    this->m_stats.maxDepth = std::max(this->m_stats.maxDepth, present - frame);
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+///////////////////////////////Desync checks//////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+unsigned long long VersusWorld::Hash(const SavedFrame& saved) const {
+    // FNV-1a
+    unsigned long long hash = 14695981039346656037ULL;
+    auto mix = [&hash](const unsigned char* data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ data[i]) * 1099511628211ULL;
+        }
+    };
+    for (const SavedState& world : saved.worlds) {
+        mix(world.world.data(), world.world.size());
+    }
+    const MatchState& match = saved.match;
+    mix(reinterpret_cast<const unsigned char*>(match.pendingAttacks.data()), sizeof(match.pendingAttacks));
+    mix(reinterpret_cast<const unsigned char*>(match.creditedScore.data()), sizeof(match.creditedScore));
+    return hash;
+}
+
+unsigned long long VersusWorld::Checksum() const {
+    SavedFrame current;
+    for (int side = 0; side < 2; side++) {
+        this->Side(side).SaveState(current.worlds[side]);
+    }
+    current.match = this->m_match;
+    return this->Hash(current);
+}
+
+void VersusWorld::UpdateChecks() {
+    // A frame's saved state is final once all input before it is confirmed
+    int settled = std::min(this->m_confirmed[this->RemoteSide()] + 1, this->m_frame - 1);
+    for (int frame = this->m_lastCheck + CHECK_INTERVAL; frame <= settled; frame += CHECK_INTERVAL) {
+        this->m_lastCheck = frame;
+        const SavedFrame& saved = this->m_saved[frame % STATE_HISTORY];
+        if (saved.frame != frame) {
+            continue;
+        }
+        this->m_checks[(frame / CHECK_INTERVAL) % this->m_checks.size()] = Check(frame, this->Hash(saved));
+        this->CompareChecks(frame);
+    }
+}
+
+void VersusWorld::CompareChecks(int frame) {
+    size_t slot = (frame / CHECK_INTERVAL) % this->m_checks.size();
+    const Check& ours = this->m_checks[slot];
+    const Check& theirs = this->m_rivalChecks[slot];
+    if (ours.first == frame && theirs.first == frame && ours.second != theirs.second
+            && !this->m_stats.desync) {
+        std::cerr << "Desync at frame " << frame << std::endl;
+        this->m_stats.desync = true;
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////Outcome/////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+VersusWorld::Outcome VersusWorld::Decide() const {
+    if (this->m_match.decidedFrame < 0) {
+        return Outcome::ONGOING;
+    }
+    int local = this->LocalSide();
+    int remote = this->RemoteSide();
+    const MatchState& match = this->m_match;
+    if (match.finished[local] != match.finished[remote]) {
+        return match.finished[local] ? Outcome::WON : Outcome::LOST;
+    }
+    if (match.finished[local] || match.lost[local] == match.lost[remote]) {
+        return Outcome::DRAW;
+    }
+    return match.lost[local] ? Outcome::LOST : Outcome::WON;
+}
+
+VersusWorld::Outcome VersusWorld::GetOutcome() const {
+    return this->m_abandoned ? Outcome::ABANDONED : this->Decide();
+}
+
+bool VersusWorld::IsGameOver() const {
+    return this->GetOutcome() != Outcome::ONGOING;
+}
+
+bool VersusWorld::IsPausable() const {
+    return false;
+}
+
+void VersusWorld::ShowStatus() {
+    if (this->m_player == nullptr) {
+        return;
+    }
+    this->UpdateStatusBar();
+    std::stringstream message;
+    message << this->GetStatusBarMessage().c_str() << "   Rival: level " << this->m_rival.GetLevel()
+        << ", score " << this->m_rival.GetScore();
+    if (!this->CanAdvance()) {
+        message << "   (waiting)";
+    }
+    this->SetStatusBarMessage(message.str());
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+////////////////////////////////FrameInput////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+bool VersusWorld::FrameInput::GetKey(KeyCode key) const {
+    if (!this->simulating) {
+        return this->device != nullptr && this->device->GetKey(key);
+    }
+    return (this->current & InputBit(key)) != 0;
+}
+
+bool VersusWorld::FrameInput::GetKeyDown(KeyCode key) {
+    if (!this->simulating) {
+        return this->device != nullptr && this->device->GetKeyDown(key);
+    }
+    unsigned char bit = InputBit(key);
+    return (this->current & bit) != 0 && (this->previous & bit) == 0;
+}
+
+bool VersusWorld::FrameInput::IsInteractive() const {
+    return this->device == nullptr || this->device->IsInteractive();
+}
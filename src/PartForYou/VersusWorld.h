@@ -0,0 +1,172 @@
+#ifndef VERSUSWORLD_H__
+#define VERSUSWORLD_H__
+
+#include <array>
+
+#include "GameWorld.h"
+#include "InputSource.h"
+#include "LocalLink.h"
+
+// Two-player versus between two processes on one machine, with rollback.
+//
+// Both players race through the same seeded levels, each in a world of its
+// own; every ATTACK_SCORE points a player earns send an extra Alphatron into
+// the rival's world. The first to clear the target level wins, losing the
+// last life loses.
+//
+// Each process simulates both worlds, this one and the rival's, in lockstep.
+// The rival's input for a frame is predicted as a repeat of its last known
+// one. When the real input arrives and differs, both worlds are restored to
+// the state saved before that frame and simulated again up to the present
+// within the same tick. Local input is applied INPUT_DELAY frames late so
+// that most rival input arrives before it is needed.
+class VersusWorld : public GameWorld {
+
+public:
+
+    enum class Role { HOST, GUEST };
+    enum class Outcome { ONGOING, WON, LOST, DRAW, ABANDONED };
+
+    struct Stats {
+        long long frames = 0;       // frames simulated for the first time
+        long long rollbacks = 0;
+        long long resimulated = 0;  // frames simulated again after a rollback
+        int maxDepth = 0;           // frames undone by the deepest rollback
+        long long stalls = 0;       // ticks spent waiting for the rival
+        bool desync = false;        // confirmed states differed between peers
+    };
+
+    explicit VersusWorld(Role);
+    virtual ~VersusWorld();
+
+    // The keyboard or a bot; sampled once per frame.
+    void SetLocalInput(InputSource*);
+    // The host listens on port, the guest on port + 1.
+    void SetPort(unsigned short);
+    // Latency and loss injected into outgoing datagrams.
+    void SetImpairment(int delayMs, int jitterMs, int lossPercent);
+    // Host only: the level that wins the match.
+    void SetTargetLevel(int);
+
+    // Waits for the rival, agrees on a seed and starts both worlds.
+    virtual void Init() override;
+    // Advances the match by at most one frame, after any rollback. The match
+    // ends with DAWNBREAKER_DESTROYED once its outcome is confirmed.
+    virtual LevelStatus Update() override;
+    // True once the match is over.
+    virtual bool IsGameOver() const override;
+    // Never: the rival keeps playing and would time out.
+    virtual bool IsPausable() const override;
+
+    GameWorld& GetRival();
+    Outcome GetOutcome() const;
+    const Stats& GetStats() const;
+    int GetFrame() const;
+    // Hash of both worlds at the start of the current frame.
+    unsigned long long Checksum() const;
+
+    static const int INPUT_DELAY = 2;
+    static const int MAX_ROLLBACK = 8;
+    static const int ATTACK_SCORE = 100;
+
+private:
+
+    static const int INPUT_HISTORY = 128;
+    static const int STATE_HISTORY = MAX_ROLLBACK + 2;
+    static const int MAX_INPUTS_PER_PACKET = 32;
+    static const int CHECK_INTERVAL = 30;
+    static const int TIMEOUT_MS = 5000;
+
+    enum PacketType : unsigned char { HELLO = 1, START, START_ACK, INPUTS };
+
+    // What a world reads while it is simulated: the input of the frame and
+    // of the frame before, for GetKeyDown(). Outside of the simulation it
+    // passes the local device through, so prompts still see the keyboard.
+    class FrameInput : public InputSource {
+    public:
+        FrameInput(): device(nullptr), simulating(false), current(0), previous(0) { }
+        bool GetKey(KeyCode) const override;
+        bool GetKeyDown(KeyCode) override;
+        bool IsInteractive() const override;
+
+        InputSource* device;
+        bool simulating;
+        unsigned char current;
+        unsigned char previous;
+    };
+
+    // Match progress that a rollback has to undo along with the worlds.
+    struct MatchState {
+        std::array<int, 2> pendingAttacks = { };
+        std::array<int, 2> creditedScore = { };
+        std::array<bool, 2> finished = { };
+        std::array<bool, 2> lost = { };
+        int decidedFrame = -1;
+    };
+
+    struct SavedFrame {
+        int frame = -1;
+        std::array<SavedState, 2> worlds;
+        MatchState match;
+    };
+
+    static unsigned char InputBit(KeyCode);
+
+    // Side 0 is the host's world.
+    GameWorld& Side(int side);
+    const GameWorld& Side(int side) const;
+    int LocalSide() const;
+    int RemoteSide() const;
+
+    bool Connect(unsigned long long& seed);
+    void Poll();
+    void SendInputs();
+    void SendPacket(PacketType, const Snapshot& payload);
+    bool CanAdvance() const;
+    unsigned char SampleLocal();
+    unsigned char InputAt(int side, int frame) const;
+    void Simulate(int frame);
+    void StepSide(int side, int frame);
+    void RollBack(int frame);
+    void UpdateChecks();
+    void CompareChecks(int frame);
+    unsigned long long Hash(const SavedFrame&) const;
+    void ShowStatus();
+    Outcome Decide() const;
+
+    Role m_role;
+    GameWorld m_rival;
+    FrameInput m_localInput;
+    FrameInput m_rivalInput;
+    LocalLink m_link;
+    unsigned short m_port;
+    int m_targetLevel;
+    bool m_connected;
+    bool m_abandoned;
+
+    int m_frame;
+    std::array<std::array<unsigned char, INPUT_HISTORY>, 2> m_inputs;
+    // Last frame whose input is known, per side.
+    std::array<int, 2> m_confirmed;
+    // Rival input each frame was last simulated with.
+    std::array<unsigned char, INPUT_HISTORY> m_used;
+    // Last local frame the rival has acknowledged.
+    int m_acked;
+    int m_rollbackTo;
+
+    MatchState m_match;
+    std::array<SavedFrame, STATE_HISTORY> m_saved;
+
+    // Desync detection: hashes of every CHECK_INTERVAL-th confirmed frame,
+    // ours and the rival's, by frame / CHECK_INTERVAL.
+    using Check = std::pair<int, unsigned long long>;
+    std::array<Check, 8> m_checks;
+    std::array<Check, 8> m_rivalChecks;
+    int m_lastCheck;
+
+    long long m_lastHeardMs;
+    Stats m_stats;
+
+};
+
+#endif  // !VERSUSWORLD_H__
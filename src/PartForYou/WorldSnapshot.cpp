@@ -0,0 +1,32 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include "WorldSnapshot.h"
+
+bool WriteSnapshotFile(const std::string& path, const Snapshot& snapshot) {
+    // Write next to the target and rename, so a crash mid-write never
+    // leaves a truncated checkpoint behind.
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(snapshot.data()), snapshot.size());
+        if (!out) {
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+    return std::rename(temp.c_str(), path.c_str()) == 0;
+}
+
+bool ReadSnapshotFile(const std::string& path, Snapshot& snapshot) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    snapshot.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
@@ -0,0 +1,86 @@
+#ifndef WORLDSNAPSHOT_H__
+#define WORLDSNAPSHOT_H__
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "MemoryTracker.h"
+
+// Binary world snapshots.
+//
+// Layout (host byte order, version 2):
+//   header   "DBSN" magic, u16 version
+//   world    i32 level, i32 score, i32 lives, i32 tick, u64 RNG state
+//   player   u8 present, then the player's state
+//   objects  u32 count per ObjectType, then per object u8 type and its state
+//   stars    u32 count, then per star f32 x, y, size
+//   blasts   u32 count, then per explosion f32 x, y, size, u8 age
+// Every object writes ObjectBase/GameObject fields first (GameObject::Save)
+// and appends its subclass state after them.
+struct SnapshotMemTag {
+    static int Id() { static int id = MemoryTracker::Instance().RegisterTag("snapshots"); return id; }
+};
+
+using Snapshot = std::vector<unsigned char, TrackingAllocator<unsigned char, SnapshotMemTag>>;
+
+const unsigned int SNAPSHOT_MAGIC = 0x4E534244; // "DBSN"
+const unsigned short SNAPSHOT_VERSION = 2;
+
+class SnapshotWriter {
+
+public:
+
+    explicit SnapshotWriter(Snapshot& out): m_out(out) { }
+
+    template<typename T>
+    void Write(T value) {
+        static_assert(std::is_trivially_copyable<T>::value, "plain values only");
+        size_t at = this->m_out.size();
+        this->m_out.resize(at + sizeof(T));
+        std::memcpy(this->m_out.data() + at, &value, sizeof(T));
+    }
+
+private:
+
+    Snapshot& m_out;
+
+};
+
+// Reads values back in order; after the first short read every further read
+// returns zero and IsGood() turns false.
+class SnapshotReader {
+
+public:
+
+    explicit SnapshotReader(const Snapshot& in): m_in(in), m_at(0), m_good(true) { }
+
+    template<typename T>
+    T Read() {
+        static_assert(std::is_trivially_copyable<T>::value, "plain values only");
+        T value{};
+        if (!this->m_good || this->m_at + sizeof(T) > this->m_in.size()) {
+            this->m_good = false;
+            return value;
+        }
+        std::memcpy(&value, this->m_in.data() + this->m_at, sizeof(T));
+        this->m_at += sizeof(T);
+        return value;
+    }
+
+    bool IsGood() const { return this->m_good; }
+    bool AtEnd() const { return this->m_at == this->m_in.size(); }
+
+private:
+
+    const Snapshot& m_in;
+    size_t m_at;
+    bool m_good;
+
+};
+
+bool WriteSnapshotFile(const std::string& path, const Snapshot&);
+bool ReadSnapshotFile(const std::string& path, Snapshot&);
+
+#endif // !WORLDSNAPSHOT_H__
@@ -0,0 +1,63 @@
+#include "CpuUsage.h"
+
+#include <iomanip>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+CpuUsage::CpuUsage(const char* const* names, int count)
+  : m_names(names), m_count(count < MAX_STATES ? count : MAX_STATES), m_state(0), m_started(false),
+    m_lastWall(), m_lastCpu(0), m_wall(), m_cpu() {}
+
+void CpuUsage::Sample(int state) {
+  Clock::time_point wall = Clock::now();
+  double cpu = ProcessCpuSeconds();
+  if (m_started) {
+    m_wall[m_state] += std::chrono::duration<double>(wall - m_lastWall).count();
+    m_cpu[m_state] += cpu - m_lastCpu;
+  }
+  m_started = true;
+  m_lastWall = wall;
+  m_lastCpu = cpu;
+  m_state = state >= 0 && state < m_count ? state : 0;
+}
+
+void CpuUsage::Print(std::ostream& out) const {
+  out << std::left << std::setw(12) << "state" << std::right << std::setw(10) << "wall s"
+      << std::setw(10) << "cpu s" << std::setw(8) << "cpu%" << "\n";
+  out << std::fixed;
+  for (int state = 0; state < m_count; state++) {
+    if (m_wall[state] <= 0) {
+      continue;
+    }
+    out << std::left << std::setw(12) << m_names[state] << std::right << std::setprecision(2)
+        << std::setw(10) << m_wall[state] << std::setw(10) << m_cpu[state]
+        << std::setprecision(1) << std::setw(8) << 100.0 * m_cpu[state] / m_wall[state] << "\n";
+  }
+  out.unsetf(std::ios::floatfield);
+}
+
+double CpuUsage::ProcessCpuSeconds() {
+#ifdef _WIN32
+  FILETIME creation, exit, kernel, user;
+  if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+    return 0;
+  }
+  ULARGE_INTEGER k, u;
+  k.LowPart = kernel.dwLowDateTime;
+  k.HighPart = kernel.dwHighDateTime;
+  u.LowPart = user.dwLowDateTime;
+  u.HighPart = user.dwHighDateTime;
+  // 100 ns units.
+  return static_cast<double>(k.QuadPart + u.QuadPart) * 1e-7;
+#else
+  timespec time;
+  if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0) {
+    return 0;
+  }
+  return static_cast<double>(time.tv_sec) + time.tv_nsec * 1e-9;
+#endif
+}
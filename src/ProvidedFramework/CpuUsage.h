@@ -0,0 +1,39 @@
+#ifndef CPUUSAGE_H__
+#define CPUUSAGE_H__
+
+#include <array>
+#include <chrono>
+#include <ostream>
+
+// Process CPU time and wall-clock time spent in each of a few states, e.g.
+// the screens of the game. Sample() attributes everything since the previous
+// sample to the state current until then, so it only has to be called
+// often enough for the attribution to be fair, not on every change.
+class CpuUsage {
+public:
+  static const int MAX_STATES = 8;
+
+  // names has to outlive the CpuUsage.
+  CpuUsage(const char* const* names, int count);
+
+  void Sample(int state);
+  // Per state: wall seconds, CPU seconds, CPU share of one core.
+  void Print(std::ostream& out) const;
+
+  // CPU time of the whole process, all threads, in seconds.
+  static double ProcessCpuSeconds();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  const char* const* m_names;
+  int m_count;
+  int m_state;
+  bool m_started;
+  Clock::time_point m_lastWall;
+  double m_lastCpu;
+  std::array<double, MAX_STATES> m_wall;
+  std::array<double, MAX_STATES> m_cpu;
+};
+
+#endif // !CPUUSAGE_H__
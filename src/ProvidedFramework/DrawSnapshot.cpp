@@ -0,0 +1,100 @@
+#include "DrawSnapshot.h"
+
+#include "ObjectBase.h"
+#include "ParticleBatch.h"
+#include "WorldBase.h"
+
+DrawSnapshot::DrawSnapshot()
+  : m_content(Content::NOTHING), m_tick(0), m_sprites(), m_batches(), m_particleX(), m_particleY(),
+    m_particleSize(), m_layerEnds(), m_statusBar(), m_overlay(), m_title(), m_subtitle() {}
+
+void DrawSnapshot::Clear(Content content, long long tick) {
+  m_content = content;
+  m_tick = tick;
+  m_sprites.clear();
+  m_batches.clear();
+  m_particleX.clear();
+  m_particleY.clear();
+  m_particleSize.clear();
+  m_layerEnds.fill(LayerEnd{ 0, 0 });
+  m_statusBar.clear();
+  m_overlay.clear();
+  m_title.clear();
+  m_subtitle.clear();
+}
+
+void DrawSnapshot::CaptureWorld(const WorldBase& world, long long tick) {
+  Clear(Content::WORLD, tick);
+  const RenderRegistry& registry = world.GetContext().registry;
+  for (int layer = MAX_LAYERS - 1; layer >= 0; layer--) {
+    ParticleBatch::DisplayLayer(registry, layer,
+      [this](const ParticleBatch& batch)
+      {
+        size_t count = batch.GetCount();
+        size_t first = m_particleX.size();
+        m_batches.push_back({ batch.GetImageID(), first, count });
+        m_particleX.resize(first + count);
+        m_particleY.resize(first + count);
+        const float* xs = batch.GetX();
+        const float* ys = batch.GetY();
+        float offsetX = batch.GetOffsetX();
+        float offsetY = batch.GetOffsetY();
+        for (size_t i = 0; i < count; i++) {
+          m_particleX[first + i] = xs[i] + offsetX;
+          m_particleY[first + i] = ys[i] + offsetY;
+        }
+        m_particleSize.insert(m_particleSize.end(), batch.GetSize(), batch.GetSize() + count);
+      });
+    ObjectBase::DisplayLayer(registry, layer,
+      [this, layer](int imageID, double x, double y, int direction, double size)
+      {
+        m_sprites.push_back({ static_cast<float>(x), static_cast<float>(y), static_cast<float>(size),
+                              static_cast<int16_t>(direction), static_cast<uint8_t>(imageID),
+                              static_cast<uint8_t>(layer) });
+      });
+    m_layerEnds[MAX_LAYERS - 1 - layer] = { m_batches.size(), m_sprites.size() };
+  }
+  m_statusBar = world.GetStatusBarMessage();
+}
+
+void DrawSnapshot::CapturePrompt(const char* title, const char* subtitle, long long tick) {
+  Clear(Content::PROMPT, tick);
+  m_title = title;
+  m_subtitle = subtitle;
+}
+
+void DrawSnapshot::SetOverlay(const HudString& overlay) {
+  m_overlay = overlay;
+}
+
+DrawSnapshot::Content DrawSnapshot::GetContent() const {
+  return m_content;
+}
+
+long long DrawSnapshot::GetTick() const {
+  return m_tick;
+}
+
+const HudString& DrawSnapshot::GetStatusBar() const {
+  return m_statusBar;
+}
+
+const HudString& DrawSnapshot::GetOverlay() const {
+  return m_overlay;
+}
+
+const HudString& DrawSnapshot::GetTitle() const {
+  return m_title;
+}
+
+const HudString& DrawSnapshot::GetSubtitle() const {
+  return m_subtitle;
+}
+
+size_t DrawSnapshot::GetSpriteCount() const {
+  return m_sprites.size();
+}
+
+size_t DrawSnapshot::GetParticleCount() const {
+  return m_particleX.size();
+}
@@ -0,0 +1,132 @@
+#ifndef DRAWSNAPSHOT_H__
+#define DRAWSNAPSHOT_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "utils.h"
+#include "MemoryTracker.h"
+#include "WorldContext.h"
+
+class WorldBase;
+
+// Everything GameManager draws for one frame, copied out of a world at the
+// end of its tick: a sprite per object, the particles of every batch with
+// the batch offset applied, the status bar, or a title prompt instead of the
+// world. The render thread draws from it and never touches live objects.
+// Captures reuse the storage of the previous one, so a snapshot stops
+// allocating once it has seen the largest frame.
+class DrawSnapshot {
+public:
+  enum class Content { NOTHING, WORLD, PROMPT };
+
+  struct Sprite {
+    float x;
+    float y;
+    float size;
+    int16_t direction;
+    uint8_t imageID;
+    uint8_t layer;
+  };
+
+  DrawSnapshot();
+
+  // Copies what the registry of world would draw and its status bar.
+  void CaptureWorld(const WorldBase& world, long long tick);
+  void CapturePrompt(const char* title, const char* subtitle, long long tick);
+  void SetOverlay(const HudString& overlay);
+
+  Content GetContent() const;
+  // The latency tick of the simulation step that produced this frame.
+  long long GetTick() const;
+  const HudString& GetStatusBar() const;
+  const HudString& GetOverlay() const;
+  const HudString& GetTitle() const;
+  const HudString& GetSubtitle() const;
+  size_t GetSpriteCount() const;
+  size_t GetParticleCount() const;
+
+  // Calls batchFunc(imageID, xs, ys, sizes, count, first) for every particle
+  // batch and spriteFunc(sprite, index) for every object, in draw order:
+  // layers from back to front, particles before the objects of the same
+  // layer. index counts particles and sprites in that order; first is the
+  // index of the first particle of the batch.
+  template<typename BatchFunc, typename SpriteFunc>
+  void Draw(BatchFunc batchFunc, SpriteFunc spriteFunc) const {
+    size_t index = 0;
+    size_t batch = 0;
+    size_t sprite = 0;
+    for (const LayerEnd& end : m_layerEnds) {
+      for (; batch < end.batches; batch++) {
+        const Batch& b = m_batches[batch];
+        batchFunc(b.imageID, m_particleX.data() + b.first, m_particleY.data() + b.first,
+                  m_particleSize.data() + b.first, b.count, index);
+        index += b.count;
+      }
+      for (; sprite < end.sprites; sprite++) {
+        spriteFunc(m_sprites[sprite], index);
+        index++;
+      }
+    }
+  }
+
+  // The same calls in the opposite order, front to back, with the same
+  // indices. Particles of a batch are still passed in draw order; callers
+  // walk them backwards.
+  template<typename BatchFunc, typename SpriteFunc>
+  void DrawFrontToBack(BatchFunc batchFunc, SpriteFunc spriteFunc) const {
+    size_t index = m_sprites.size() + m_particleX.size();
+    size_t batch = m_batches.size();
+    size_t sprite = m_sprites.size();
+    for (size_t end = m_layerEnds.size(); end > 0; end--) {
+      size_t firstBatch = end > 1 ? m_layerEnds[end - 2].batches : 0;
+      size_t firstSprite = end > 1 ? m_layerEnds[end - 2].sprites : 0;
+      for (; sprite > firstSprite; sprite--) {
+        index--;
+        spriteFunc(m_sprites[sprite - 1], index);
+      }
+      for (; batch > firstBatch; batch--) {
+        const Batch& b = m_batches[batch - 1];
+        index -= b.count;
+        batchFunc(b.imageID, m_particleX.data() + b.first, m_particleY.data() + b.first,
+                  m_particleSize.data() + b.first, b.count, index);
+      }
+    }
+  }
+
+private:
+  template<typename T>
+  using Buffer = std::vector<T, TrackingAllocator<T, DrawMemTag>>;
+
+  // A range of the particle arrays drawn with one image.
+  struct Batch {
+    int imageID;
+    size_t first;
+    size_t count;
+  };
+
+  // Where each layer stops in m_batches and m_sprites, back layer first.
+  struct LayerEnd {
+    size_t batches;
+    size_t sprites;
+  };
+
+  void Clear(Content content, long long tick);
+
+  Content m_content;
+  long long m_tick;
+  Buffer<Sprite> m_sprites;
+  Buffer<Batch> m_batches;
+  Buffer<float> m_particleX;
+  Buffer<float> m_particleY;
+  Buffer<float> m_particleSize;
+  std::array<LayerEnd, MAX_LAYERS> m_layerEnds;
+  HudString m_statusBar;
+  HudString m_overlay;
+  HudString m_title;
+  HudString m_subtitle;
+};
+
+#endif // !DRAWSNAPSHOT_H__
@@ -0,0 +1,414 @@
+#include "FrameCapture.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <GL/freeglut.h>
+
+#include "TraceRecorder.h"
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+#ifndef GL_BGRA
+#define GL_BGRA 0x80E1
+#endif
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_READ_ONLY
+#define GL_READ_ONLY 0x88B8
+#endif
+
+// Buffer objects are newer than the GL 1.1 some platforms (Windows) link
+// against, so their entry points are looked up at run time.
+struct BufferFunctions {
+  void (APIENTRY* genBuffers)(GLsizei, GLuint*) = nullptr;
+  void (APIENTRY* deleteBuffers)(GLsizei, const GLuint*) = nullptr;
+  void (APIENTRY* bindBuffer)(GLenum, GLuint) = nullptr;
+  void (APIENTRY* bufferData)(GLenum, std::ptrdiff_t, const void*, GLenum) = nullptr;
+  void* (APIENTRY* mapBuffer)(GLenum, GLenum) = nullptr;
+  GLboolean (APIENTRY* unmapBuffer)(GLenum) = nullptr;
+};
+
+static BufferFunctions g_buffers;
+
+template<typename Proc>
+static bool LoadProc(Proc& proc, const char* name, const char* suffix) {
+  proc = reinterpret_cast<Proc>(glutGetProcAddress((std::string(name) + suffix).c_str()));
+  return proc != nullptr;
+}
+
+static bool LoadBufferFunctions() {
+  const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+  const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  int major = 0;
+  int minor = 0;
+  if (version != nullptr) {
+    sscanf(version, "%d.%d", &major, &minor);
+  }
+  const char* suffix = "";
+  if (major < 2 || (major == 2 && minor < 1)) {
+    if (extensions == nullptr || strstr(extensions, "GL_ARB_pixel_buffer_object") == nullptr) {
+      return false;
+    }
+    suffix = "ARB";
+  }
+  return LoadProc(g_buffers.genBuffers, "glGenBuffers", suffix) &&
+         LoadProc(g_buffers.deleteBuffers, "glDeleteBuffers", suffix) &&
+         LoadProc(g_buffers.bindBuffer, "glBindBuffer", suffix) &&
+         LoadProc(g_buffers.bufferData, "glBufferData", suffix) &&
+         LoadProc(g_buffers.mapBuffer, "glMapBuffer", suffix) &&
+         LoadProc(g_buffers.unmapBuffer, "glUnmapBuffer", suffix);
+}
+
+// BT.601, studio range, as Y4M players expect.
+static unsigned char Luma(int r, int g, int b) {
+  return static_cast<unsigned char>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+static unsigned char ChromaBlue(int r, int g, int b) {
+  return static_cast<unsigned char>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+
+static unsigned char ChromaRed(int r, int g, int b) {
+  return static_cast<unsigned char>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+FrameCapture::FrameCapture()
+  : m_path(), m_namePrefix(), m_nameSuffix(), m_nameDigits(0), m_format(Format::Y4M), m_width(0), m_height(0), m_open(false), m_glReady(false), m_usePbo(false),
+    m_ring(), m_next(0), m_sequence(0), m_captured(0), m_dropped(0), m_buffers(), m_bufferSequence(), m_mutex(),
+    m_wakeUp(), m_free(), m_queue(), m_closing(false), m_written(0), m_failed(0), m_encoder(), m_y4m(),
+    m_scratch(), m_readLoad(), m_encodeLoad() {}
+
+FrameCapture::~FrameCapture() {
+  // Without the GL context, which is gone by now: only stop the encoder.
+  if (m_encoder.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_closing = true;
+    }
+    m_wakeUp.notify_all();
+    m_encoder.join();
+  }
+}
+
+bool FrameCapture::Open(const std::string& path, int width, int height, int msPerFrame) {
+  if (m_open) {
+    return false;
+  }
+  const std::string y4m = ".y4m";
+  bool isY4M = path.size() >= y4m.size() && path.compare(path.size() - y4m.size(), y4m.size(), y4m) == 0;
+  if (isY4M) {
+    if (width % 2 != 0 || height % 2 != 0) {
+      std::cerr << "Cannot capture " << width << "x" << height << " as 4:2:0" << std::endl;
+      return false;
+    }
+    m_y4m.open(path, std::ios::binary);
+    if (!m_y4m) {
+      std::cerr << "Cannot write capture '" << path << "'" << std::endl;
+      return false;
+    }
+    m_y4m << "YUV4MPEG2 W" << width << " H" << height << " F1000:" << msPerFrame
+          << " Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n";
+    m_format = Format::Y4M;
+    m_scratch.resize(static_cast<size_t>(width) * height * 3 / 2);
+  }
+  else {
+    if (!ParsePattern(path)) {
+      std::cerr << "Capture '" << path << "' is neither a .y4m file nor a pattern with one %d, like frames/%05d.tga"
+                << std::endl;
+      return false;
+    }
+    m_format = Format::TGA;
+    m_scratch.resize(static_cast<size_t>(width) * height * 3);
+  }
+  m_path = path;
+  m_width = width;
+  m_height = height;
+  m_buffers.assign(BUFFER_COUNT, Pixels(static_cast<size_t>(width) * height * BYTES_PER_PIXEL));
+  m_bufferSequence.assign(BUFFER_COUNT, 0);
+  for (int buffer = BUFFER_COUNT - 1; buffer >= 0; buffer--) {
+    m_free.push_back(buffer);
+  }
+  m_closing = false;
+  m_encoder = std::thread(&FrameCapture::EncoderLoop, this);
+  m_open = true;
+  return true;
+}
+
+bool FrameCapture::IsOpen() const {
+  return m_open;
+}
+
+void FrameCapture::InitGL() {
+  m_glReady = true;
+  m_usePbo = LoadBufferFunctions();
+  if (!m_usePbo) {
+    std::cerr << "No pixel buffer objects, capturing frames synchronously" << std::endl;
+    return;
+  }
+  size_t bytes = static_cast<size_t>(m_width) * m_height * BYTES_PER_PIXEL;
+  for (Readback& readback : m_ring) {
+    g_buffers.genBuffers(1, &readback.pbo);
+    g_buffers.bindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+    g_buffers.bufferData(GL_PIXEL_PACK_BUFFER, static_cast<std::ptrdiff_t>(bytes), nullptr, GL_STREAM_READ);
+    MemoryTracker::Instance().Allocate(CaptureMemTag::Id(), bytes);
+  }
+  g_buffers.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void FrameCapture::Capture() {
+  if (!m_open) {
+    return;
+  }
+  TraceRecorder::Scope trace("frame", "FrameCapture::Capture");
+  m_readLoad.Begin();
+  if (!m_glReady) {
+    InitGL();
+  }
+  // The slot written RING_SIZE frames ago: its read is done by now, so
+  // mapping it does not wait.
+  Readback& readback = m_ring[m_next];
+  m_next = (m_next + 1) % RING_SIZE;
+  if (readback.pending) {
+    Collect(readback);
+  }
+
+  m_sequence++;
+  int buffer = TakeBuffer();
+  if (buffer < 0) {
+    m_dropped++;
+    m_readLoad.End();
+    return;
+  }
+  m_bufferSequence[buffer] = m_sequence;
+  glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+  glPixelStorei(GL_PACK_ALIGNMENT, BYTES_PER_PIXEL);
+  glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+  if (m_usePbo) {
+    // Queues the copy and returns; the pixels land in the buffer object.
+    g_buffers.bindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+    glReadPixels(0, 0, m_width, m_height, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+    g_buffers.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.buffer = buffer;
+    readback.pending = true;
+  }
+  else {
+    glReadPixels(0, 0, m_width, m_height, GL_BGRA, GL_UNSIGNED_BYTE, m_buffers[buffer].data());
+    Submit(buffer);
+  }
+  glPopClientAttrib();
+  m_captured++;
+  m_readLoad.End();
+}
+
+void FrameCapture::Collect(Readback& readback) {
+  g_buffers.bindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+  const void* pixels = g_buffers.mapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+  Pixels& buffer = m_buffers[readback.buffer];
+  if (pixels != nullptr) {
+    memcpy(buffer.data(), pixels, buffer.size());
+    g_buffers.unmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  g_buffers.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  if (pixels != nullptr) {
+    Submit(readback.buffer);
+  }
+  else {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.push_back(readback.buffer);
+    m_failed++;
+  }
+  readback.buffer = -1;
+  readback.pending = false;
+}
+
+int FrameCapture::TakeBuffer() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_free.empty()) {
+    return -1;
+  }
+  int buffer = m_free.back();
+  m_free.pop_back();
+  return buffer;
+}
+
+void FrameCapture::Submit(int buffer) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queue.push_back(buffer);
+  }
+  m_wakeUp.notify_one();
+}
+
+void FrameCapture::Close() {
+  if (!m_open) {
+    return;
+  }
+  if (m_glReady && m_usePbo) {
+    // Oldest first, so the frames stay in order.
+    for (int i = 0; i < RING_SIZE; i++) {
+      Readback& readback = m_ring[(m_next + i) % RING_SIZE];
+      if (readback.pending) {
+        Collect(readback);
+      }
+      g_buffers.deleteBuffers(1, &readback.pbo);
+      readback.pbo = 0;
+      MemoryTracker::Instance().Deallocate(CaptureMemTag::Id(),
+                                           static_cast<size_t>(m_width) * m_height * BYTES_PER_PIXEL);
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closing = true;
+  }
+  m_wakeUp.notify_all();
+  m_encoder.join();
+  m_y4m.close();
+  m_open = false;
+}
+
+void FrameCapture::EncoderLoop() {
+  TraceRecorder::Instance().SetThreadName("capture");
+  while (true) {
+    int buffer;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wakeUp.wait(lock, [this] { return m_closing || !m_queue.empty(); });
+      if (m_queue.empty()) {
+        return;
+      }
+      buffer = m_queue.front();
+      m_queue.pop_front();
+    }
+    TraceRecorder::Scope trace("capture", "FrameCapture::Encode");
+    m_encodeLoad.Begin();
+    bool written = m_format == Format::Y4M ? WriteY4M(m_buffers[buffer])
+                                           : WriteTGA(m_buffers[buffer], m_bufferSequence[buffer]);
+    m_encodeLoad.End();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.push_back(buffer);
+    if (written) {
+      m_written++;
+    }
+    else {
+      m_failed++;
+    }
+  }
+}
+
+bool FrameCapture::WriteY4M(const Pixels& pixels) {
+  size_t stride = static_cast<size_t>(m_width) * BYTES_PER_PIXEL;
+  unsigned char* lumaPlane = m_scratch.data();
+  unsigned char* bluePlane = lumaPlane + static_cast<size_t>(m_width) * m_height;
+  unsigned char* redPlane = bluePlane + static_cast<size_t>(m_width / 2) * (m_height / 2);
+  for (int row = 0; row < m_height; row += 2) {
+    // Y4M goes top down, glReadPixels bottom up.
+    const unsigned char* upper = pixels.data() + (m_height - 1 - row) * stride;
+    const unsigned char* lower = upper - stride;
+    unsigned char* lumaUpper = lumaPlane + static_cast<size_t>(row) * m_width;
+    unsigned char* lumaLower = lumaUpper + m_width;
+    size_t chroma = static_cast<size_t>(row / 2) * (m_width / 2);
+    for (int col = 0; col < m_width; col += 2) {
+      int r = 0;
+      int g = 0;
+      int b = 0;
+      for (int dx = 0; dx < 2; dx++) {
+        const unsigned char* top = upper + (col + dx) * BYTES_PER_PIXEL;
+        const unsigned char* bottom = lower + (col + dx) * BYTES_PER_PIXEL;
+        lumaUpper[col + dx] = Luma(top[2], top[1], top[0]);
+        lumaLower[col + dx] = Luma(bottom[2], bottom[1], bottom[0]);
+        r += top[2] + bottom[2];
+        g += top[1] + bottom[1];
+        b += top[0] + bottom[0];
+      }
+      // One chroma sample per 2x2 block, from the block's mean colour.
+      bluePlane[chroma + col / 2] = ChromaBlue((r + 2) / 4, (g + 2) / 4, (b + 2) / 4);
+      redPlane[chroma + col / 2] = ChromaRed((r + 2) / 4, (g + 2) / 4, (b + 2) / 4);
+    }
+  }
+  m_y4m << "FRAME\n";
+  m_y4m.write(reinterpret_cast<const char*>(m_scratch.data()), static_cast<std::streamsize>(m_scratch.size()));
+  return static_cast<bool>(m_y4m);
+}
+
+bool FrameCapture::ParsePattern(const std::string& path) {
+  m_namePrefix.clear();
+  m_nameSuffix.clear();
+  m_nameDigits = 0;
+  bool number = false;
+  for (size_t i = 0; i < path.size(); i++) {
+    std::string& part = number ? m_nameSuffix : m_namePrefix;
+    if (path[i] != '%') {
+      part += path[i];
+      continue;
+    }
+    if (i + 1 < path.size() && path[i + 1] == '%') {
+      part += '%';
+      i++;
+      continue;
+    }
+    // %d or %0Nd with up to two digits of N
+    size_t end = i + 1;
+    int digits = 0;
+    if (end < path.size() && path[end] == '0') {
+      end++;
+      for (int n = 0; n < 2 && end < path.size() && isdigit(static_cast<unsigned char>(path[end])); n++) {
+        digits = digits * 10 + (path[end++] - '0');
+      }
+    }
+    if (number || end >= path.size() || path[end] != 'd') {
+      return false;
+    }
+    number = true;
+    m_nameDigits = digits;
+    i = end;
+  }
+  return number;
+}
+
+bool FrameCapture::WriteTGA(const Pixels& pixels, long long sequence) {
+  std::string digits = std::to_string(sequence);
+  if (static_cast<int>(digits.size()) < m_nameDigits) {
+    digits.insert(0, m_nameDigits - digits.size(), '0');
+  }
+  std::ofstream out(m_namePrefix + digits + m_nameSuffix, std::ios::binary);
+  if (!out) {
+    return false;
+  }
+  // Uncompressed true colour, 24 bits, origin bottom left: glReadPixels'
+  // row order, so only the alpha channel has to go.
+  unsigned char header[18] = { 0, 0, 2 };
+  header[12] = static_cast<unsigned char>(m_width & 0xFF);
+  header[13] = static_cast<unsigned char>(m_width >> 8);
+  header[14] = static_cast<unsigned char>(m_height & 0xFF);
+  header[15] = static_cast<unsigned char>(m_height >> 8);
+  header[16] = 24;
+  size_t count = static_cast<size_t>(m_width) * m_height;
+  for (size_t i = 0; i < count; i++) {
+    m_scratch[3 * i] = pixels[BYTES_PER_PIXEL * i];
+    m_scratch[3 * i + 1] = pixels[BYTES_PER_PIXEL * i + 1];
+    m_scratch[3 * i + 2] = pixels[BYTES_PER_PIXEL * i + 2];
+  }
+  out.write(reinterpret_cast<const char*>(header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(m_scratch.data()), static_cast<std::streamsize>(3 * count));
+  return static_cast<bool>(out);
+}
+
+void FrameCapture::Print(std::ostream& out) const {
+  m_readLoad.Print(out, "capture", "frames");
+  m_encodeLoad.Print(out, "encode", "frames");
+  std::lock_guard<std::mutex> lock(m_mutex);
+  out << m_captured << " frames captured" << (m_glReady && !m_usePbo ? " synchronously" : "") << ", "
+      << m_written << " written to '" << m_path << "', " << m_dropped << " dropped while the encoder was behind";
+  if (m_failed > 0) {
+    out << ", " << m_failed << " failed";
+  }
+  out << std::endl;
+}
@@ -0,0 +1,125 @@
+#ifndef FRAMECAPTURE_H__
+#define FRAMECAPTURE_H__
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/glut.h>
+
+#include "MemoryTracker.h"
+#include "ThreadLoad.h"
+
+// Records what the window shows, e.g. footage of a performance regression.
+//
+// glReadPixels into client memory waits for the GPU to finish the frame.
+// Instead each frame is read into one of a ring of pixel buffer objects and
+// only mapped RING_SIZE - 1 frames later, when the copy has long completed.
+// The pixels are then handed to an encoder thread that writes a YUV4MPEG2
+// stream or numbered TGA images. When the encoder falls behind and none of
+// its buffers is free, frames are dropped instead of waited for.
+//
+// Everything but the encoding runs on the thread owning the GL context.
+// Without pixel buffer objects (GL < 2.1 and no ARB_pixel_buffer_object)
+// frames are read synchronously, which does stall.
+class FrameCapture {
+public:
+  FrameCapture();
+  ~FrameCapture();
+  FrameCapture(const FrameCapture& other) = delete;
+  FrameCapture& operator=(const FrameCapture& other) = delete;
+
+  // A path ending in ".y4m" gets one YUV4MPEG2 stream at 1000 / msPerFrame
+  // frames per second; anything else is a pattern for numbered TGA images
+  // with exactly one %d or %0Nd, e.g. "frames/%05d.tga", and %% for a
+  // literal percent sign. Needs no GL context yet.
+  bool Open(const std::string& path, int width, int height, int msPerFrame);
+  bool IsOpen() const;
+
+  // Reads the lower left width x height pixels of the back buffer; call
+  // after drawing a frame and before swapping buffers.
+  void Capture();
+  // Collects the frames still being read, lets the encoder finish and
+  // closes the output. The GL context must still exist.
+  void Close();
+
+  // Time spent per frame on the GL thread and on the encoder thread, and
+  // how many frames were written and dropped.
+  void Print(std::ostream& out) const;
+
+private:
+  enum class Format { Y4M, TGA };
+
+  // Reads in flight: a frame of the ring counts as pending from its
+  // glReadPixels until it is mapped and handed over.
+  static const int RING_SIZE = 3;
+  // Frames the encoder can fall behind by before frames are dropped.
+  static const int BUFFER_COUNT = 8;
+  static const int BYTES_PER_PIXEL = 4;
+
+  using Pixels = std::vector<unsigned char, TrackingAllocator<unsigned char, CaptureMemTag>>;
+
+  struct Readback {
+    GLuint pbo = 0;
+    int buffer = -1;
+    bool pending = false;
+  };
+
+  // Splits a TGA pattern into what goes before and after the frame number.
+  bool ParsePattern(const std::string& path);
+  void InitGL();
+  // Maps a pending read and hands its pixels to the encoder.
+  void Collect(Readback& readback);
+  int TakeBuffer();
+  void Submit(int buffer);
+  void EncoderLoop();
+  bool WriteY4M(const Pixels& pixels);
+  bool WriteTGA(const Pixels& pixels, long long sequence);
+
+  std::string m_path;
+  // TGA names: prefix, frame number padded with zeros to m_nameDigits, suffix.
+  std::string m_namePrefix;
+  std::string m_nameSuffix;
+  int m_nameDigits;
+  Format m_format;
+  int m_width;
+  int m_height;
+  bool m_open;
+  bool m_glReady;
+  bool m_usePbo;
+
+  std::array<Readback, RING_SIZE> m_ring;
+  int m_next;
+  long long m_sequence;
+  long long m_captured;
+  long long m_dropped;
+
+  // One frame each, BGRA, bottom row first like glReadPixels.
+  std::vector<Pixels> m_buffers;
+  std::vector<long long> m_bufferSequence;
+
+  // Hand-off to the encoder thread.
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wakeUp;
+  std::vector<int> m_free;
+  std::deque<int> m_queue;
+  bool m_closing;
+  long long m_written;
+  long long m_failed;
+  std::thread m_encoder;
+
+  // Encoder thread only.
+  std::ofstream m_y4m;
+  Pixels m_scratch;
+
+  ThreadLoad m_readLoad;
+  ThreadLoad m_encodeLoad;
+};
+
+#endif // !FRAMECAPTURE_H__
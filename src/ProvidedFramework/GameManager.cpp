@@ -7,8 +7,13 @@
 #include "utils.h"
 #include "ObjectBase.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+
 static void displayCallback() {
-  GameManager::Instance().Update();
+  GameManager::Instance().ExposeEvent();
 }
 
 static void keyboardDownEventCallback(unsigned char key, int x, int y) {
@@ -25,11 +30,30 @@ static void specialKeyboardUpEventCallback(int key, int x, int y) {
   GameManager::Instance().SpecialKeyUpEvent(key, x, y);
 }
 
-static void timerCallback(int) {
-  GameManager::Instance().Update();
-  glutTimerFunc(MS_PER_FRAME, &timerCallback, 0);
+static void closeCallback() {
+  GameManager::Instance().Shutdown();
+}
+
+static void timerCallback(int generation) {
+  GameManager::Instance().Frame(generation);
+}
+
+static void reshapeCallback(int width, int height) {
+  GameManager::Instance().ReshapeEvent(width, height);
+}
+
+static void windowStatusCallback(int status) {
+  GameManager::Instance().WindowStatusEvent(status);
+}
+
+// Depth of the draw with the given index among count: each draw is nearer
+// than the ones before it.
+static float DrawDepth(size_t index, size_t count) {
+  return 1.0f - 2.0f * static_cast<float>(index + 1) / static_cast<float>(count + 1);
 }
 
+static const char* const CPU_STATES[] = { "title", "playing", "prompt", "game over", "hidden" };
+
 void displayText(double x, double y, double z, const char* str, bool centering, void* font = GLUT_BITMAP_HELVETICA_10) {
   if (centering) {
     int pixelLength = glutBitmapLength(font, reinterpret_cast<const unsigned char*>(str));
@@ -45,14 +69,31 @@ void displayText(double x, double y, double z, const char* str, bool centering,
   glPopMatrix();
 }
 
-GameManager::GameManager() : m_gameState(GameManager::GameState::TITLE), m_pause(false), m_pressedKeys(), m_statusBar() {
+GameManager::GameManager()
+  : m_gameState(GameManager::GameState::TITLE), m_inputMutex(), m_wakeUp(), m_pressedKeys(), m_keyEvents(0),
+    m_keyEventsSeen(0), m_hidden(false), m_memoryOverlay(), m_frames(0),
+    m_pause(false), m_latency(), m_keyboard(*this), m_sprites(), m_prefetchLevel(0), m_text(), m_glutText(false), m_textAttempts(0), m_memoryLog(), m_showMemory(false),
+    m_perfCounters(false), m_singleThreaded(false), m_simulation(), m_stopping(false), m_quitRequested(false),
+    m_drawFrames(), m_framesDropped(0), m_framesRepeated(0), m_framesSkipped(0), m_simulationLoad(), m_renderLoad(),
+    m_swapLoad(), m_hudLoad(), m_idleThrottling(true), m_dirty(true), m_timerGeneration(0), m_fastFrames(0),
+    m_cpuUsage(CPU_STATES, sizeof(CPU_STATES) / sizeof(CPU_STATES[0])), m_capture(), m_lastFrameStart(), m_opaqueFirst(false),
+    m_overdrawView(false), m_countOverdraw(false), m_fillBenchFrames(0) {
 
 }
 
 void GameManager::Play(int argc, char** argv, std::shared_ptr<WorldBase> world) {
   m_world = world;
+  if (m_world->GetInputSource() == nullptr) {
+    m_world->SetInputSource(&m_keyboard);
+  }
 
-  glutInitDisplayMode(GLUT_RGB | GLUT_DEPTH | GLUT_DOUBLE);
+  if (m_fillBenchFrames > 0) {
+    // Nothing may step the world behind the benchmark's back.
+    m_singleThreaded = true;
+  }
+  // Overdraw is counted in the stencil buffer.
+  bool stencil = m_overdrawView || m_fillBenchFrames > 0;
+  glutInitDisplayMode(GLUT_RGB | GLUT_DEPTH | GLUT_DOUBLE | (stencil ? GLUT_STENCIL : 0));
   glutInitWindowSize(WINDOW_WIDTH, WINDOW_HEIGHT);
   glutInitWindowPosition(0, 0);
 
@@ -64,31 +105,155 @@ void GameManager::Play(int argc, char** argv, std::shared_ptr<WorldBase> world)
   glutSpecialFunc(&specialKeyboardDownEventCallback);
   glutSpecialUpFunc(&specialKeyboardUpEventCallback);
   glutDisplayFunc(&displayCallback);
-  glutTimerFunc(MS_PER_FRAME, &timerCallback, 0);
-
-  // Initialize SpriteManager and load sprites.
-  SpriteManager::Instance();
+  glutReshapeFunc(&reshapeCallback);
+  glutWindowStatusFunc(&windowStatusCallback);
+  glutCloseFunc(&closeCallback);
+  ArmTimer(MS_PER_FRAME);
+
+  TraceRecorder::Instance().SetThreadName("main");
+
+  // Sprites need a GL context; only those drawn from the start load now.
+  m_sprites = std::make_unique<SpriteManager>();
+  Prompt("DAWNBREAKER", "Press Enter to start");
+  m_cpuUsage.Sample(static_cast<int>(m_gameState.load()));
+  if (m_singleThreaded) {
+    if (m_perfCounters) {
+      PerfCounters::Instance().Enable();
+    }
+  }
+  else {
+    m_simulation = std::thread(&GameManager::SimulationLoop, this);
+  }
   glutMainLoop();
 }
 
+void GameManager::SimulationLoop() {
+  TraceRecorder::Instance().SetThreadName("simulation");
+  if (m_perfCounters) {
+    PerfCounters::Instance().Enable();
+  }
+  ThreadLoad::Clock::time_point next = ThreadLoad::Clock::now();
+  while (!m_stopping) {
+    WaitForWork();
+    if (m_stopping) {
+      break;
+    }
+    m_simulationLoad.Begin();
+    Update();
+    m_simulationLoad.End();
+    // Like the GLUT timer it replaces: a late tick delays the following ones
+    // instead of being caught up with a burst.
+    next = std::max(next + std::chrono::milliseconds(MS_PER_FRAME), ThreadLoad::Clock::now());
+    std::this_thread::sleep_until(next);
+  }
+}
+
+void GameManager::StopSimulation() {
+  {
+    std::lock_guard<std::mutex> lock(m_inputMutex);
+    m_stopping = true;
+  }
+  m_wakeUp.notify_all();
+  if (m_simulation.joinable()) {
+    m_simulation.join();
+  }
+}
+
+bool GameManager::HasWork() const {
+  if (!m_idleThrottling) {
+    return true;
+  }
+  if (m_gameState != GameState::ANIMATING) {
+    // Prompts only react to keys, and only a bot presses them without a key
+    // event.
+    InputSource* input = m_world->GetInputSource();
+    return m_keyEvents != m_keyEventsSeen || (input != nullptr && !input->IsInteractive());
+  }
+  return !m_hidden || !m_world->IsPausable();
+}
+
+void GameManager::WaitForWork() {
+  std::unique_lock<std::mutex> lock(m_inputMutex);
+  m_wakeUp.wait(lock, [this] { return m_stopping || HasWork(); });
+  m_keyEventsSeen = m_keyEvents;
+}
+
+bool GameManager::TakeWork() {
+  std::lock_guard<std::mutex> lock(m_inputMutex);
+  bool work = HasWork();
+  m_keyEventsSeen = m_keyEvents;
+  return work;
+}
+
+void GameManager::ArmTimer(int ms) {
+  glutTimerFunc(ms, &timerCallback, ++m_timerGeneration);
+}
+
+void GameManager::Wake() {
+  m_wakeUp.notify_all();
+  bool slow = m_fastFrames == 0;
+  m_fastFrames = FAST_FRAMES;
+  // No timer before Play() has created the window.
+  if (slow && m_idleThrottling && m_timerGeneration > 0) {
+    ArmTimer(0);
+  }
+}
+
+void GameManager::Frame(int generation) {
+  if (generation != m_timerGeneration) {
+    return;
+  }
+  if (m_singleThreaded && TakeWork()) {
+    m_simulationLoad.Begin();
+    Update();
+    m_simulationLoad.End();
+  }
+  if (m_quitRequested) {
+    Quit();
+  }
+  Display();
+
+  bool idle = m_hidden || m_gameState != GameState::ANIMATING;
+  m_cpuUsage.Sample(m_hidden ? HIDDEN_STATE : static_cast<int>(m_gameState.load()));
+  if (m_fastFrames > 0) {
+    m_fastFrames--;
+  }
+  if (!m_idleThrottling || !idle || m_fastFrames > 0 || (m_singleThreaded && !m_world->IsPausable())) {
+    ArmTimer(MS_PER_FRAME);
+  }
+  else {
+    ArmTimer(IDLE_FRAME_MS);
+  }
+}
+
 void GameManager::Update() {
-  if (m_pause) return;
+  if (m_pause || m_quitRequested) return;
+  TraceRecorder::Scope trace("frame", "GameManager::Update");
+  m_frames++;
+  if (m_memoryLog.is_open() && m_frames % MEMORY_DUMP_FRAMES == 0) {
+    MemoryTracker::Instance().Dump(m_memoryLog, m_frames);
+  }
+  if (m_showMemory && m_frames % 30 == 0) {
+    std::string summary = MemoryTracker::Instance().Summary();
+    m_memoryOverlay.assign(summary.begin(), summary.end());
+  }
   if (GetKey(KeyCode::QUIT)) {
-    exit(EXIT_SUCCESS);
+    m_quitRequested = true;
+    return;
   }
   switch (m_gameState) {
   case GameManager::GameState::TITLE:
-    Prompt("DAWNBREAKER", "Press Enter to start");
-    if (GetKey(KeyCode::ENTER)) {
+    if (m_world->GetKey(KeyCode::ENTER)) {
       m_world->Init();
       m_gameState = GameManager::GameState::ANIMATING;
-      Display();
+      PublishFrame();
     }
     break;
   case GameManager::GameState::ANIMATING:
   {
+    m_latency.OnTick();
     LevelStatus status = m_world->Update();
-    Display();
+    PublishFrame();
     switch (status) {
     case LevelStatus::ONGOING:
       break;
@@ -116,15 +281,15 @@ void GameManager::Update() {
     break;
   }
   case GameManager::GameState::PROMPTING:
-    if (GetKey(KeyCode::ENTER)) {
+    if (m_world->GetKey(KeyCode::ENTER)) {
       m_world->Init();
       m_gameState = GameManager::GameState::ANIMATING;
-      Display();
+      PublishFrame();
     } 
     break;
   case GameManager::GameState::GAMEOVER:
-    if (GetKey(KeyCode::ENTER)) {
-      exit(EXIT_SUCCESS);
+    if (m_world->GetKey(KeyCode::ENTER)) {
+      m_quitRequested = true;
     }
     break;
   default:
@@ -137,46 +302,92 @@ void GameManager::KeyDownEvent(unsigned char key, int x, int y) {
   //  m_pause ^= 1;
   //  return;
   //}
-  KeyCode keyCode = ToKeyCode(key);
-  if (keyCode != KeyCode::NONE) {
-    if (m_pressedKeys.find(keyCode) == m_pressedKeys.end()) {
-      m_pressedKeys.insert({ keyCode, true });
-    }
-  }
+  PressKey(ToKeyCode(key));
 }
 void GameManager::KeyUpEvent(unsigned char key, int x, int y) {
-  KeyCode keyCode = ToKeyCode(key);
-  if (keyCode != KeyCode::NONE) {
-    if (m_pressedKeys.find(keyCode) != m_pressedKeys.end()) {
-      m_pressedKeys.erase(keyCode);
+  ReleaseKey(ToKeyCode(key));
+}
+
+void GameManager::SpecialKeyDownEvent(int key, int x, int y) {
+  if (key == GLUT_KEY_F12 && TraceRecorder::Instance().IsEnabled()) {
+    if (TraceRecorder::Instance().Write()) {
+      std::cout << "Trace written" << std::endl;
     }
+    return;
   }
+  PressKey(SpecialToKeyCode(key));
 }
 
-void GameManager::SpecialKeyDownEvent(int key, int x, int y) {
-  KeyCode keyCode = SpecialToKeyCode(key);
-  if (keyCode != KeyCode::NONE) {
+void GameManager::SpecialKeyUpEvent(int key, int x, int y) {
+  ReleaseKey(SpecialToKeyCode(key));
+}
+
+void GameManager::PressKey(KeyCode keyCode) {
+  if (keyCode == KeyCode::NONE) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_inputMutex);
+    m_keyEvents++;
     if (m_pressedKeys.find(keyCode) == m_pressedKeys.end()) {
       m_pressedKeys.insert({ keyCode, true });
+      m_latency.OnKeyDown(keyCode);
     }
   }
+  Wake();
 }
 
-void GameManager::SpecialKeyUpEvent(int key, int x, int y) {
-  KeyCode keyCode = SpecialToKeyCode(key);
-  if (keyCode != KeyCode::NONE) {
+void GameManager::ReleaseKey(KeyCode keyCode) {
+  if (keyCode == KeyCode::NONE) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_inputMutex);
+    m_keyEvents++;
     if (m_pressedKeys.find(keyCode) != m_pressedKeys.end()) {
       m_pressedKeys.erase(keyCode);
+      m_latency.OnKeyUp(keyCode);
     }
   }
+  Wake();
+}
+
+void GameManager::ReshapeEvent(int width, int height) {
+  glViewport(0, 0, width, height);
+  m_dirty = true;
+}
+
+void GameManager::ExposeEvent() {
+  if (m_fillBenchFrames > 0) {
+    // Drawing only counts once the window is on screen.
+    RunFillBench();
+    Quit();
+    return;
+  }
+  m_dirty = true;
+  Display();
+}
+
+void GameManager::WindowStatusEvent(int status) {
+  bool hidden = status == GLUT_HIDDEN || status == GLUT_FULLY_COVERED;
+  {
+    std::lock_guard<std::mutex> lock(m_inputMutex);
+    m_hidden = hidden;
+  }
+  if (!hidden) {
+    m_dirty = true;
+  }
+  Wake();
 }
 
 
 bool GameManager::GetKey(KeyCode key) const {
+  std::lock_guard<std::mutex> lock(m_inputMutex);
   return m_pressedKeys.find(key) != m_pressedKeys.end();
 }
 
 bool GameManager::GetKeyDown(KeyCode key) {
+  std::lock_guard<std::mutex> lock(m_inputMutex);
   auto keyEntry = m_pressedKeys.find(key);
   if (keyEntry != m_pressedKeys.end()) {
     if (keyEntry->second) {
@@ -190,23 +401,219 @@ bool GameManager::GetKeyDown(KeyCode key) {
   return false;
 }
 
-void GameManager::SetStatusBarMessage(std::string message) {
-  m_statusBar = message;
+InputSource& GameManager::GetKeyboard() {
+  return m_keyboard;
+}
+
+bool GameManager::Keyboard::GetKey(KeyCode key) const {
+  bool pressed = m_manager.GetKey(key);
+  if (pressed) {
+    m_manager.OnKeyRead(key);
+  }
+  return pressed;
+}
+
+bool GameManager::Keyboard::GetKeyDown(KeyCode key) {
+  bool pressed = m_manager.GetKeyDown(key);
+  if (pressed) {
+    m_manager.OnKeyRead(key);
+  }
+  return pressed;
+}
+
+void GameManager::OnKeyRead(KeyCode key) {
+  // Only keys read by a tick reach the ship; Enter answering a prompt is
+  // not timed.
+  if (m_gameState == GameState::ANIMATING) {
+    m_latency.OnKeyConsumed(key);
+  }
+  else {
+    m_latency.OnKeyIgnored(key);
+  }
+}
+
+void GameManager::EnableMemoryLog(const std::string& logPath) {
+  m_memoryLog.open(logPath, std::ios::app);
+  if (!m_memoryLog) {
+    std::cerr << "Cannot write memory log '" << logPath << "'" << std::endl;
+    return;
+  }
+  m_memoryLog << "# tick,tag,live_bytes,live_allocations,peak_bytes,total_allocations\n";
+}
+
+void GameManager::EnableMemoryOverlay() {
+  m_showMemory = true;
+}
+
+void GameManager::EnablePerfCounters() {
+  m_perfCounters = true;
+}
+
+void GameManager::SetSingleThreaded(bool singleThreaded) {
+  m_singleThreaded = singleThreaded;
+}
+
+void GameManager::SetGlutText(bool glutText) {
+  m_glutText = glutText;
+}
+
+void GameManager::SetIdleThrottling(bool idleThrottling) {
+  m_idleThrottling = idleThrottling;
+}
+
+bool GameManager::EnableCapture(const std::string& path) {
+  return m_capture.Open(path, WINDOW_WIDTH, WINDOW_HEIGHT, MS_PER_FRAME);
+}
+
+void GameManager::SetOpaqueFirst(bool opaqueFirst) {
+  m_opaqueFirst = opaqueFirst;
+}
+
+void GameManager::EnableOverdrawView() {
+  m_overdrawView = true;
+  m_countOverdraw = true;
+}
+
+void GameManager::EnableFillBench(int frames) {
+  m_fillBenchFrames = frames;
+}
+
+void GameManager::EnableLatencyLog(const std::string& logPath) {
+  m_latency.Enable(logPath);
+}
+
+LatencyTracker& GameManager::GetLatencyTracker() {
+  return m_latency;
+}
+
+void GameManager::Shutdown() {
+  StopSimulation();
+  m_latency.Report();
+  if (TraceRecorder::Instance().IsEnabled()) {
+    TraceRecorder::Instance().Write();
+  }
+  PerfCounters::Instance().Report(std::cout);
+  if (m_memoryLog.is_open()) {
+    MemoryTracker::Instance().Dump(m_memoryLog, m_frames);
+  }
+  m_simulationLoad.Print(std::cout, "simulation", "ticks ");
+  m_renderLoad.Print(std::cout, "render", "frames");
+  m_swapLoad.Print(std::cout, "swap", "frames");
+  m_hudLoad.Print(std::cout, "hud", "frames");
+  if (m_text != nullptr && m_text->IsReady()) {
+    std::cout << m_text->GetDrawCount() << " strings drawn, " << m_text->GetLayoutCount() << " laid out" << std::endl;
+  }
+  // Shutdown runs in GLUT callbacks, so the atlases go while their context is current.
+  m_text.reset();
+  if (m_renderLoad.GetCount() > 0) {
+    std::cout << m_framesDropped << " frames replaced before being drawn, "
+              << m_framesRepeated << " drawn again, " << m_framesSkipped << " skipped as unchanged" << std::endl;
+  }
+  m_cpuUsage.Sample(m_hidden ? HIDDEN_STATE : static_cast<int>(m_gameState.load()));
+  m_cpuUsage.Print(std::cout);
+  if (m_capture.IsOpen()) {
+    m_capture.Close();
+    m_capture.Print(std::cout);
+  }
+  if (Telemetry::Instance().IsEnabled()) {
+    Telemetry::Instance().Close();
+    Telemetry::Instance().Print(std::cout);
+  }
+}
+
+void GameManager::Quit() {
+  Shutdown();
+  exit(EXIT_SUCCESS);
+}
+
+void GameManager::PublishFrame() {
+  TraceRecorder::Scope trace("frame", "PublishFrame");
+  DrawSnapshot& frame = m_drawFrames.Back();
+  frame.CaptureWorld(*m_world, m_latency.GetTick());
+  if (m_showMemory) {
+    frame.SetOverlay(m_memoryOverlay);
+  }
+  if (!m_drawFrames.Publish()) {
+    m_framesDropped++;
+  }
 }
 
 void GameManager::Display() {
+  TraceRecorder::Scope trace("frame", "Display");
+  bool fresh = m_drawFrames.Acquire();
+  if (m_idleThrottling && (m_hidden || (!fresh && !m_dirty))) {
+    m_framesSkipped++;
+    return;
+  }
+  if (!fresh) {
+    m_framesRepeated++;
+  }
+  m_dirty = false;
+  const DrawSnapshot& frame = m_drawFrames.Front();
+  ThreadLoad::Clock::time_point frameStart = ThreadLoad::Clock::now();
+
+  if (!m_glutText && m_textAttempts < TEXT_ATTEMPTS && (m_text == nullptr || !m_text->IsReady())) {
+    // Glyphs can only be read back once the window is on screen.
+    m_text = std::make_unique<TextRenderer>();
+    if (!m_text->IsReady() && ++m_textAttempts == TEXT_ATTEMPTS) {
+      std::cerr << "Cannot build the glyph atlas, drawing text with glutBitmapString" << std::endl;
+    }
+  }
+
+  m_renderLoad.Begin();
   glEnable(GL_DEPTH_TEST); 
   glLoadIdentity();
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | (m_countOverdraw ? GL_STENCIL_BUFFER_BIT : 0));
 
-  ObjectBase::DisplayAllObjects(
-    [=](int imageID, double x, double y, int angle, double size)
-    {
-      GameManager::Instance().DrawOneObject(imageID, x, y, angle, size);
-    });
+  if (frame.GetContent() == DrawSnapshot::Content::PROMPT) {
+    m_hudLoad.Begin();
+    DrawPrompt(frame);
+    m_hudLoad.End();
+  }
+  else if (frame.GetContent() == DrawSnapshot::Content::WORLD) {
+    PerfCounters& perf = PerfCounters::Instance();
+    perf.Begin(PerfCounters::Phase::RENDER);
+    DrawWorld(frame);
+    if (m_overdrawView) {
+      DrawOverdraw();
+    }
+
+    m_hudLoad.Begin();
+    DrawHudText(-1.0 + 25.0 / WINDOW_WIDTH, -1.0 + 25.0 / WINDOW_HEIGHT , 0, frame.GetStatusBar().c_str(), false, TextRenderer::Font::HELVETICA_12);
+    if (!frame.GetOverlay().empty()) {
+      DrawHudText(-1.0 + 25.0 / WINDOW_WIDTH, -1.0 + 60.0 / WINDOW_HEIGHT, 0, frame.GetOverlay().c_str(), false, TextRenderer::Font::HELVETICA_10);
+    }
+    m_hudLoad.End();
+    perf.End(PerfCounters::Phase::RENDER, frame.GetSpriteCount() + frame.GetParticleCount());
+  }
+  m_renderLoad.End();
 
-  displayText(-1.0 + 25.0 / WINDOW_WIDTH, -1.0 + 25.0 / WINDOW_HEIGHT , 0, m_statusBar.c_str(), false, GLUT_BITMAP_HELVETICA_12);
+  // Reads the back buffer, so before it is swapped away.
+  m_capture.Capture();
+
+  m_swapLoad.Begin();
+  TraceRecorder::Instance().Begin("frame", "SwapBuffers");
   glutSwapBuffers();
+  TraceRecorder::Instance().End("frame", "SwapBuffers");
+  m_swapLoad.End();
+  m_latency.OnFramePresented(frame.GetTick());
+
+  if (frame.GetContent() == DrawSnapshot::Content::PROMPT) {
+    // Behind a prompt that is already on screen, so the wait goes unseen.
+    m_sprites->Prefetch(m_prefetchLevel.load());
+  }
+
+  Telemetry& telemetry = Telemetry::Instance();
+  if (telemetry.IsEnabled()) {
+    using Micros = std::chrono::microseconds;
+    ThreadLoad::Clock::time_point frameEnd = ThreadLoad::Clock::now();
+    long long interval = m_lastFrameStart == ThreadLoad::Clock::time_point() ? 0
+        : std::chrono::duration_cast<Micros>(frameStart - m_lastFrameStart).count();
+    telemetry.Emit(Telemetry::Kind::FRAME, static_cast<int>(frame.GetTick()), 0,
+                   static_cast<int>(std::chrono::duration_cast<Micros>(frameEnd - frameStart).count()),
+                   static_cast<int>(interval));
+  }
+  m_lastFrameStart = frameStart;
 }
 
 double GameManager::NormalizeCoord(double pixels, double totalPixels) const {
@@ -220,16 +627,74 @@ inline void GameManager::Rotate(double x, double y, double degrees, double& xout
   yout = y * cos(theta) - x * sin(theta);
 }
 
-void GameManager::DrawOneObject(int imageID, double x, double y, int direction, double size) {
-  GLuint texture = SpriteManager::Instance().GetTexture(imageID);
-  glPushMatrix();
-  glPushAttrib(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+void GameManager::DrawWorld(const DrawSnapshot& frame) {
+  size_t total = frame.GetSpriteCount() + frame.GetParticleCount();
+  auto sprites = [this, total](const DrawSnapshot::Sprite& sprite, size_t index) {
+    DrawOneObject(sprite.imageID, sprite.x, sprite.y, sprite.direction, sprite.size, DrawDepth(index, total));
+  };
+  auto particles = [this, total](bool frontToBack) {
+    return [this, total, frontToBack](int imageID, const float* xs, const float* ys, const float* sizes,
+                                      size_t count, size_t first) {
+      DrawParticles(imageID, xs, ys, sizes, count, first, total, frontToBack);
+    };
+  };
+  if (!m_opaqueFirst) {
+    BeginSprites(SpritePass::BLENDED);
+    frame.Draw(particles(false), sprites);
+    EndSprites();
+    return;
+  }
+  BeginSprites(SpritePass::OPAQUE);
+  frame.DrawFrontToBack(particles(true), sprites);
+  EndSprites();
+  BeginSprites(SpritePass::EDGES);
+  frame.Draw(particles(false), sprites);
+  EndSprites();
+}
 
+void GameManager::BeginSprites(SpritePass pass) {
+  glPushAttrib(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_ENABLE_BIT | GL_STENCIL_BUFFER_BIT);
   glEnable(GL_TEXTURE_2D);
-  glDisable(GL_DEPTH_TEST);
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glBindTexture(GL_TEXTURE_2D, texture);
+  switch (pass) {
+  case SpritePass::BLENDED:
+    glDisable(GL_DEPTH_TEST);
+    break;
+  case SpritePass::OPAQUE:
+    // Nearest first, so a texel hidden by one drawn already fails the depth
+    // test instead of being textured and blended.
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GEQUAL, OPAQUE_ALPHA);
+    break;
+  case SpritePass::EDGES:
+    // Farthest first, tested against but not writing depth: the opaque
+    // texels of the sprite itself are at its own depth and fail GL_LESS,
+    // as does anything behind a nearer opaque texel.
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_FALSE);
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.0f);
+    break;
+  }
+  if (m_countOverdraw) {
+    glEnable(GL_STENCIL_TEST);
+    glStencilFunc(GL_ALWAYS, 0, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+  }
+}
+
+void GameManager::EndSprites() {
+  glPopAttrib();
+}
+
+void GameManager::DrawOneObject(int imageID, double x, double y, int direction, double size, float z) {
+  glBindTexture(GL_TEXTURE_2D, m_sprites->GetTexture(imageID));
 
   double centerX = NormalizeCoord(x, WINDOW_WIDTH);
   double centerY = NormalizeCoord(y, WINDOW_HEIGHT);
@@ -243,28 +708,142 @@ void GameManager::DrawOneObject(int imageID, double x, double y, int direction,
   Rotate(-halfW, halfH, direction, x4, y4);
 
   glBegin(GL_QUADS);
-  glTexCoord2f(0, 0); 		glVertex3f((float)(centerX + x1 / WINDOW_WIDTH), (float)(centerY + y1 / WINDOW_HEIGHT), 0);
-  glTexCoord2f(1, 0); 		glVertex3f((float)(centerX + x2 / WINDOW_WIDTH), (float)(centerY + y2 / WINDOW_HEIGHT), 0);
-  glTexCoord2f(1, 1); 		glVertex3f((float)(centerX + x3 / WINDOW_WIDTH), (float)(centerY + y3 / WINDOW_HEIGHT), 0);
-  glTexCoord2f(0, 1); 		glVertex3f((float)(centerX + x4 / WINDOW_WIDTH), (float)(centerY + y4 / WINDOW_HEIGHT), 0);
+  glTexCoord2f(0, 0); 		glVertex3f((float)(centerX + x1 / WINDOW_WIDTH), (float)(centerY + y1 / WINDOW_HEIGHT), z);
+  glTexCoord2f(1, 0); 		glVertex3f((float)(centerX + x2 / WINDOW_WIDTH), (float)(centerY + y2 / WINDOW_HEIGHT), z);
+  glTexCoord2f(1, 1); 		glVertex3f((float)(centerX + x3 / WINDOW_WIDTH), (float)(centerY + y3 / WINDOW_HEIGHT), z);
+  glTexCoord2f(0, 1); 		glVertex3f((float)(centerX + x4 / WINDOW_WIDTH), (float)(centerY + y4 / WINDOW_HEIGHT), z);
   glEnd();
+}
+
+void GameManager::DrawParticles(int imageID, const float* xs, const float* ys, const float* sizes, size_t count,
+                                size_t first, size_t total, bool frontToBack) {
+  glBindTexture(GL_TEXTURE_2D, m_sprites->GetTexture(imageID));
 
+  // Same quad as DrawOneObject with direction 0, for every particle at once.
+  glBegin(GL_QUADS);
+  for (size_t n = 0; n < count; n++) {
+    size_t i = frontToBack ? count - 1 - n : n;
+    float centerX = (float)NormalizeCoord(xs[i], WINDOW_WIDTH);
+    float centerY = (float)NormalizeCoord(ys[i], WINDOW_HEIGHT);
+    float halfW = sizes[i] * 100.0f / WINDOW_WIDTH;
+    float halfH = sizes[i] * 100.0f / WINDOW_HEIGHT;
+    float z = DrawDepth(first + i, total);
+    glTexCoord2f(0, 0); 		glVertex3f(centerX - halfW, centerY - halfH, z);
+    glTexCoord2f(1, 0); 		glVertex3f(centerX + halfW, centerY - halfH, z);
+    glTexCoord2f(1, 1); 		glVertex3f(centerX + halfW, centerY + halfH, z);
+    glTexCoord2f(0, 1); 		glVertex3f(centerX - halfW, centerY + halfH, z);
+  }
+  glEnd();
+}
+
+void GameManager::DrawOverdraw() {
+  // Drawn never (black), once (dark blue), ... up to OVERDRAW_LEVELS or
+  // more times (white).
+  static const float HEAT[OVERDRAW_LEVELS + 1][3] = {
+    { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.5f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.6f, 1.0f }, { 0.0f, 0.8f, 0.0f },
+    { 0.8f, 0.8f, 0.0f }, { 1.0f, 0.5f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f }
+  };
+  glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_STENCIL_BUFFER_BIT);
   glDisable(GL_TEXTURE_2D);
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_BLEND);
+  glEnable(GL_STENCIL_TEST);
+  glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+  for (int level = 0; level <= OVERDRAW_LEVELS; level++) {
+    // The last level takes every count from there up.
+    glStencilFunc(level < OVERDRAW_LEVELS ? GL_EQUAL : GL_LEQUAL, level, 0xFF);
+    glColor3fv(HEAT[level]);
+    glRectf(-1.0f, -1.0f, 1.0f, 1.0f);
+  }
+  glPopAttrib();
+}
 
+void GameManager::RunFillBench() {
+  // A busy screen: the first FILL_BENCH_TICKS ticks of a level.
+  m_world->Init();
+  for (int tick = 0; tick < FILL_BENCH_TICKS && m_world->Update() == LevelStatus::ONGOING; tick++) {
+  }
+  DrawSnapshot frame;
+  frame.CaptureWorld(*m_world, 0);
+  std::cout << "fill bench: " << frame.GetSpriteCount() << " sprites, " << frame.GetParticleCount()
+            << " particles, " << m_fillBenchFrames << " frames per mode" << std::endl;
+
+  const size_t pixels = static_cast<size_t>(WINDOW_WIDTH) * WINDOW_HEIGHT;
+  std::vector<unsigned char> stencil(pixels);
+  std::vector<unsigned char> blended(pixels * 3);
+  std::vector<unsigned char> picture(pixels * 3);
+  bool opaqueFirst = m_opaqueFirst;
+  glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  for (bool mode : { false, true }) {
+    m_opaqueFirst = mode;
+
+    // Fragments written, counted once in the stencil buffer, and the
+    // picture, to check it against the blended one.
+    m_countOverdraw = true;
+    glLoadIdentity();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    DrawWorld(frame);
+    m_countOverdraw = false;
+    glReadPixels(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, stencil.data());
+    glReadPixels(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, mode ? picture.data() : blended.data());
+    long long fragments = 0;
+    for (unsigned char count : stencil) {
+      fragments += count;
+    }
+    int difference = 0;
+    for (size_t i = 0; mode && i < picture.size(); i++) {
+      difference = std::max(difference, std::abs(picture[i] - blended[i]));
+    }
 
-  glEnable(GL_DEPTH_TEST);
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < m_fillBenchFrames; i++) {
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      DrawWorld(frame);
+    }
+    glFinish();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+                m_fillBenchFrames;
+
+    std::cout << std::left << std::setw(14) << (mode ? "opaque-first" : "blended") << std::right << std::fixed
+              << std::setprecision(3) << std::setw(9) << ms << " ms/frame"
+              << std::setprecision(2) << std::setw(7) << static_cast<double>(fragments) / pixels
+              << "x window written" << std::setprecision(1) << std::setw(9) << fragments / (ms * 1000.0)
+              << " Mfragments/s";
+    if (mode) {
+      std::cout << "  max difference " << difference << "/255";
+    }
+    std::cout << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+  }
+  glPopClientAttrib();
+  m_opaqueFirst = opaqueFirst;
+  m_countOverdraw = m_overdrawView;
+}
 
-  glPopAttrib();
-  glPopMatrix();
+void GameManager::Prompt(const char* title, const char* subtitle) {
+  m_prefetchLevel = m_world->GetLevel();
+  m_drawFrames.Back().CapturePrompt(title, subtitle, m_latency.GetTick());
+  if (!m_drawFrames.Publish()) {
+    m_framesDropped++;
+  }
 }
 
-void GameManager::Prompt(const char* title, const char* subtitle) const {
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+void GameManager::DrawPrompt(const DrawSnapshot& frame) {
   glColor3f(1.0f, 1.0f, 0.5f);
-  displayText(0, 0.25, -1, title, true, GLUT_BITMAP_HELVETICA_18);
+  DrawHudText(0, 0.25, -1, frame.GetTitle().c_str(), true, TextRenderer::Font::HELVETICA_18);
   glColor3f(1.0f, 1.0f, 1.0f);
-  displayText(0, -0.2, -1, subtitle, true, GLUT_BITMAP_HELVETICA_12);
-  glutSwapBuffers();
+  DrawHudText(0, -0.2, -1, frame.GetSubtitle().c_str(), true, TextRenderer::Font::HELVETICA_12);
+}
+
+void GameManager::DrawHudText(double x, double y, double z, const char* text, bool centering, TextRenderer::Font font) {
+  if (m_text != nullptr && m_text->IsReady()) {
+    m_text->Draw(font, x, y, text, centering);
+  }
+  else {
+    displayText(x, y, z, text, centering, TextRenderer::GlutFont(font));
+  }
 }
 
 inline KeyCode GameManager::ToKeyCode(unsigned char key) const {
@@ -1,14 +1,49 @@
 #ifndef GAMEMANAGER_H__
 #define GAMEMANAGER_H__
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 
+#include "CpuUsage.h"
+#include "DrawSnapshot.h"
+#include "FrameCapture.h"
 #include "ObjectBase.h"
+#include "ParticleBatch.h"
+#include "SpriteManager.h"
 #include "WorldBase.h"
+#include "LatencyTracker.h"
+#include "MemoryTracker.h"
+#include "PerfCounters.h"
+#include "Telemetry.h"
+#include "TextRenderer.h"
+#include "TraceRecorder.h"
+#include "ThreadLoad.h"
+#include "TripleBuffer.h"
 
 #include <vector>
 #include <map>
+#include <fstream>
 
+// Owns the window. It stays a singleton only because GLUT callbacks are
+// plain functions; worlds never reach it, they get the keyboard as an
+// InputSource and keep their own status bar.
+//
+// The world is stepped on a simulation thread of its own. At the end of
+// every tick it captures a DrawSnapshot and publishes it through a triple
+// buffer; the GLUT thread, which owns the GL context, draws the newest
+// snapshot on every timer tick. Neither waits for the other, so a swap
+// blocked on vsync no longer delays the simulation and a slow tick no longer
+// delays presenting. SetSingleThreaded() steps and draws on the GLUT thread
+// instead, as before.
+//
+// Nothing runs that would not change the screen: a frame is drawn only when
+// a new snapshot was published or the window was exposed or resized, the
+// simulation sleeps until the next key while a prompt is up, and while the
+// window is hidden nothing is drawn and pausable worlds are not stepped.
+// The GLUT timer slows down meanwhile.
 class GameManager {
 public:
   // Mayers' singleton pattern
@@ -21,36 +56,200 @@ public:
 
   bool GetKey(KeyCode key) const;
   bool GetKeyDown(KeyCode key);
-  void SetStatusBarMessage(std::string message);
+  // The keyboard as an InputSource, for worlds that sample it themselves.
+  InputSource& GetKeyboard();
 
+  // Records key-to-frame latency and writes the histogram to logPath on exit.
+  void EnableLatencyLog(const std::string& logPath);
+  LatencyTracker& GetLatencyTracker();
+
+  // Appends a MemoryTracker dump to logPath every MEMORY_DUMP_FRAMES frames
+  // and on exit.
+  void EnableMemoryLog(const std::string& logPath);
+  // Shows the MemoryTracker summary above the status bar.
+  void EnableMemoryOverlay();
+  // Opens the PerfCounters on the thread that steps the world. With the
+  // simulation thread the render phase is not counted.
+  void EnablePerfCounters();
+  // Steps the world on the GLUT thread instead of a thread of its own.
+  void SetSingleThreaded(bool singleThreaded);
+  // Draws text with glutBitmapString instead of the glyph atlas, to compare
+  // the cost of the HUD.
+  void SetGlutText(bool glutText);
+  // With false, ticks and draws every MS_PER_FRAME whatever the state, to
+  // compare the CPU usage of the idle screens.
+  void SetIdleThrottling(bool idleThrottling);
+  // Records every frame drawn to path, see FrameCapture::Open().
+  bool EnableCapture(const std::string& path);
+  // Draws the opaque texels of all sprites first, front to back with depth
+  // testing so that hidden texels are rejected, then only the translucent
+  // rest back to front with blending. Same picture, less fill.
+  void SetOpaqueFirst(bool opaqueFirst);
+  // Shows how many times each pixel of the world was drawn instead of the
+  // world itself.
+  void EnableOverdrawView();
+  // Once the window is up: draws a busy frame the given number of times in
+  // each render mode, prints the fill rate and quits.
+  void EnableFillBench(int frames);
+
+  // Called by the GLUT timer; timers armed before the latest one are ignored.
+  void Frame(int generation);
+  // Steps the world by one tick and publishes what it looks like.
   void Update();
+  // Draws the newest published frame.
   void Display();
 
   void KeyDownEvent(unsigned char key, int x, int y);
   void KeyUpEvent(unsigned char key, int x, int y);
   void SpecialKeyDownEvent(int key, int x, int y);
   void SpecialKeyUpEvent(int key, int x, int y);
+  void ReshapeEvent(int width, int height);
+  void ExposeEvent();
+  // GLUT_HIDDEN, GLUT_FULLY_RETAINED, ...
+  void WindowStatusEvent(int status);
+
+  // Flushes reports (latency log, trace, ...) before the process goes away.
+  void Shutdown();
 
-  inline void DrawOneObject(int imageID, double x, double y, int direction, double size);
 private:
   enum class GameState{TITLE, ANIMATING, PROMPTING, GAMEOVER};
+  // BLENDED draws every texel back to front; OPAQUE and EDGES are the two
+  // passes of SetOpaqueFirst().
+  enum class SpritePass { BLENDED, OPAQUE, EDGES };
+  // The CpuUsage states: the GameStates, then the hidden window.
+  static const int HIDDEN_STATE = 4;
   GameManager();
   double NormalizeCoord(double pixels, double totalPixels) const;
   inline void Rotate(double x, double y, double degrees, double& xout, double& yout) const;
-  void Prompt(const char* title, const char* subtitle) const;
+  void Prompt(const char* title, const char* subtitle);
+  void DrawPrompt(const DrawSnapshot& frame);
+  void DrawHudText(double x, double y, double z, const char* text, bool centering, TextRenderer::Font font);
+  void DrawWorld(const DrawSnapshot& frame);
+  // GL state for a pass over the sprites; the draws in between only bind
+  // textures and emit quads.
+  void BeginSprites(SpritePass pass);
+  void EndSprites();
+  // z is the depth of the sprite, from DrawDepth().
+  inline void DrawOneObject(int imageID, double x, double y, int direction, double size, float z);
+  // Particle i is draw first + i of total; walks them backwards when
+  // frontToBack.
+  void DrawParticles(int imageID, const float* xs, const float* ys, const float* sizes, size_t count,
+                     size_t first, size_t total, bool frontToBack);
+  // Colours the window by the stencil counts BeginSprites() left.
+  void DrawOverdraw();
+  void RunFillBench();
+  void PublishFrame();
+  void SimulationLoop();
+  void StopSimulation();
+  void Quit();
+
+  // Whether a tick could change anything. Needs m_inputMutex.
+  bool HasWork() const;
+  // Simulation thread: blocks until HasWork().
+  void WaitForWork();
+  // GLUT thread without the simulation thread: HasWork(), and marks the key
+  // events so far as seen.
+  bool TakeWork();
+  void ArmTimer(int ms);
+  // Key or window events: a frame soon, and the simulation woken up.
+  void Wake();
+  void PressKey(KeyCode keyCode);
+  void ReleaseKey(KeyCode keyCode);
+  // The world read a pressed key from the keyboard.
+  void OnKeyRead(KeyCode key);
 
   inline KeyCode ToKeyCode(unsigned char key) const;
   inline KeyCode SpecialToKeyCode(int key) const;
 
-  GameState m_gameState;
+  // The keyboard as seen by the world: reads GameManager's pressed keys and
+  // reports each key a tick consumed to the LatencyTracker.
+  class Keyboard : public InputSource {
+  public:
+    explicit Keyboard(GameManager& manager) : m_manager(manager) {}
+    bool GetKey(KeyCode key) const override;
+    bool GetKeyDown(KeyCode key) override;
+    bool IsInteractive() const override { return true; }
+  private:
+    GameManager& m_manager;
+  };
+
+  std::atomic<GameState> m_gameState;
   std::shared_ptr<WorldBase> m_world;
 
+  // Key state and window status: written by GLUT events, read by the
+  // simulation, which m_wakeUp wakes up when they change.
+  mutable std::mutex m_inputMutex;
+  std::condition_variable m_wakeUp;
   std::map<KeyCode, bool> m_pressedKeys;
+  long long m_keyEvents;
+  long long m_keyEventsSeen;
+  bool m_hidden;
   //KeyCode m_lastKey;
 
-  std::string m_statusBar;
+  static const int MEMORY_DUMP_FRAMES = 3750; // about a minute
+
+  HudString m_memoryOverlay;
+  long long m_frames;
 
   bool m_pause;
 
+  LatencyTracker m_latency;
+  Keyboard m_keyboard;
+  std::unique_ptr<SpriteManager> m_sprites;
+  // The level the prompt on screen leads to, set by the simulation; its
+  // sprites are loaded once the prompt has been drawn.
+  std::atomic<int> m_prefetchLevel;
+  static const int TEXT_ATTEMPTS = 10;
+
+  std::unique_ptr<TextRenderer> m_text;
+  bool m_glutText;
+  int m_textAttempts;
+  std::ofstream m_memoryLog;
+  bool m_showMemory;
+  bool m_perfCounters;
+
+  bool m_singleThreaded;
+  std::thread m_simulation;
+  std::atomic<bool> m_stopping;
+  // Set by the simulation, acted on by the GLUT thread.
+  std::atomic<bool> m_quitRequested;
+
+  TripleBuffer<DrawSnapshot> m_drawFrames;
+  long long m_framesDropped;   // published but replaced before being drawn
+  long long m_framesRepeated;  // drawn again because nothing newer was published
+  long long m_framesSkipped;   // not drawn since nothing changed
+  ThreadLoad m_simulationLoad;
+  ThreadLoad m_renderLoad;
+  ThreadLoad m_swapLoad;
+  ThreadLoad m_hudLoad;
+
+  static const int IDLE_FRAME_MS = 100;
+  // Frames at full rate after an event, so its outcome is drawn promptly.
+  static const int FAST_FRAMES = 30;
+
+  bool m_idleThrottling;
+  bool m_dirty;
+  int m_timerGeneration;
+  int m_fastFrames;
+  CpuUsage m_cpuUsage;
+  FrameCapture m_capture;
+  // Start of the previous frame drawn, for the telemetry frame interval.
+  ThreadLoad::Clock::time_point m_lastFrameStart;
+
+  // Texels at least this opaque are drawn in the OPAQUE pass.
+  static constexpr float OPAQUE_ALPHA = 254.0f / 255.0f;
+  // Overdraw above this shows in the hottest colour.
+  static const int OVERDRAW_LEVELS = 8;
+  // Ticks stepped before the fill benchmark, for a screen full of stars,
+  // ships and explosions.
+  static const int FILL_BENCH_TICKS = 600;
+
+  bool m_opaqueFirst;
+  bool m_overdrawView;
+  // Whether BeginSprites() counts the fragments written in the stencil
+  // buffer.
+  bool m_countOverdraw;
+  int m_fillBenchFrames;
+
 };
 #endif // !GAMEMANAGER_H__
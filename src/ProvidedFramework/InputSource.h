@@ -0,0 +1,23 @@
+#ifndef INPUTSOURCE_H__
+#define INPUTSOURCE_H__
+
+#include "utils.h"
+
+// Where a world reads its controls from. A world without one sees no key
+// pressed; GameManager plugs in its keyboard unless a bot or a replay was
+// set first.
+class InputSource {
+public:
+  virtual ~InputSource() {}
+
+  // The key is held.
+  virtual bool GetKey(KeyCode key) const = 0;
+  // The key was pressed since the last time this returned true for it.
+  virtual bool GetKeyDown(KeyCode key) = 0;
+  // Whether presses come from a person at the keyboard, whose key events
+  // wake GameManager up. Other sources, like a bot, are asked every tick,
+  // prompts included.
+  virtual bool IsInteractive() const { return false; }
+};
+
+#endif // !INPUTSOURCE_H__
@@ -0,0 +1,163 @@
+#include "LatencyTracker.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+LatencyTracker::Histogram::Histogram() : m_buckets(), m_count(0), m_max(0.0) {}
+
+void LatencyTracker::Histogram::Add(double ms) {
+  int bucket = std::min(std::max(static_cast<int>(ms), 0), BUCKETS);
+  m_buckets[bucket]++;
+  m_count++;
+  m_max = std::max(m_max, ms);
+}
+
+int LatencyTracker::Histogram::GetCount() const {
+  return m_count;
+}
+
+double LatencyTracker::Histogram::GetMax() const {
+  return m_max;
+}
+
+double LatencyTracker::Histogram::Percentile(double p) const {
+  if (m_count == 0) {
+    return 0.0;
+  }
+  int rank = static_cast<int>(p / 100.0 * m_count + 0.5);
+  rank = std::min(std::max(rank, 1), m_count);
+  int seen = 0;
+  for (int i = 0; i < BUCKETS; i++) {
+    seen += m_buckets[i];
+    if (seen >= rank) {
+      return i + 1.0;
+    }
+  }
+  return m_max;
+}
+
+void LatencyTracker::Histogram::Print(std::ostream& out, const char* name) const {
+  out << std::left << std::setw(16) << name << std::right
+      << std::setw(8) << m_count
+      << std::setw(8) << Percentile(50)
+      << std::setw(8) << Percentile(95)
+      << std::setw(8) << Percentile(99)
+      << std::setw(10) << std::fixed << std::setprecision(2) << m_max << "\n";
+  out.unsetf(std::ios::floatfield);
+}
+
+void LatencyTracker::Histogram::PrintBuckets(std::ostream& out) const {
+  for (int i = 0; i <= BUCKETS; i++) {
+    if (m_buckets[i] == 0) continue;
+    if (i < BUCKETS) {
+      out << std::setw(4) << i << "-" << std::left << std::setw(4) << i + 1 << std::right;
+    }
+    else {
+      out << std::setw(4) << BUCKETS << "+   ";
+    }
+    out << std::setw(8) << m_buckets[i] << " " << std::string(std::min(m_buckets[i], 60), '#') << "\n";
+  }
+}
+
+LatencyTracker::LatencyTracker()
+  : m_mutex(), m_enabled(false), m_logPath(), m_tick(0), m_dropped(0), m_pending(), m_keyToTick(), m_keyToPresent() {}
+
+void LatencyTracker::Enable(const std::string& logPath) {
+  m_enabled = true;
+  m_logPath = logPath;
+}
+
+bool LatencyTracker::IsEnabled() const {
+  return m_enabled;
+}
+
+void LatencyTracker::OnKeyDown(KeyCode key) {
+  if (!m_enabled) return;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto& press : m_pending) {
+    if (press.key == key) {
+      return;
+    }
+  }
+  m_pending.push_back({ key, Clock::now(), Clock::time_point(), -1 });
+}
+
+void LatencyTracker::OnKeyUp(KeyCode key) {
+  if (!m_enabled) return;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  // A press released before any tick looked at it never reached the ship.
+  auto it = std::remove_if(m_pending.begin(), m_pending.end(), [key](const PendingPress& press) {
+    return press.key == key && press.consumedTick < 0;
+  });
+  m_dropped += static_cast<int>(m_pending.end() - it);
+  m_pending.erase(it, m_pending.end());
+}
+
+void LatencyTracker::OnTick() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_tick++;
+}
+
+long long LatencyTracker::GetTick() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_tick;
+}
+
+void LatencyTracker::OnKeyConsumed(KeyCode key) {
+  if (!m_enabled) return;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto& press : m_pending) {
+    if (press.key == key && press.consumedTick < 0) {
+      press.consumedTick = m_tick;
+      press.consumed = Clock::now();
+      m_keyToTick.Add(ElapsedMs(press.pressed, press.consumed));
+    }
+  }
+}
+
+void LatencyTracker::OnKeyIgnored(KeyCode key) {
+  if (!m_enabled) return;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(), [key](const PendingPress& press) {
+    return press.key == key && press.consumedTick < 0;
+  }), m_pending.end());
+}
+
+void LatencyTracker::OnFramePresented(long long tick) {
+  if (!m_enabled) return;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Clock::time_point now = Clock::now();
+  auto it = std::remove_if(m_pending.begin(), m_pending.end(), [&](const PendingPress& press) {
+    if (press.consumedTick < 0 || press.consumedTick > tick) {
+      return false;
+    }
+    m_keyToPresent.Add(ElapsedMs(press.pressed, now));
+    return true;
+  });
+  m_pending.erase(it, m_pending.end());
+}
+
+void LatencyTracker::Report() const {
+  if (!m_enabled) return;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::ofstream out(m_logPath);
+  if (!out) {
+    std::cerr << "Cannot write latency log '" << m_logPath << "'" << std::endl;
+    return;
+  }
+  out << "# Dawnbreaker input latency, " << m_tick << " ticks, "
+      << m_dropped << " presses released before any tick read them\n";
+  out << std::left << std::setw(16) << "stage" << std::right
+      << std::setw(8) << "count" << std::setw(8) << "p50" << std::setw(8) << "p95"
+      << std::setw(8) << "p99" << std::setw(10) << "max(ms)" << "\n";
+  m_keyToTick.Print(out, "key->tick");
+  m_keyToPresent.Print(out, "key->present");
+  out << "\n# key->present histogram (ms)\n";
+  m_keyToPresent.PrintBuckets(out);
+}
+
+double LatencyTracker::ElapsedMs(Clock::time_point from, Clock::time_point to) {
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
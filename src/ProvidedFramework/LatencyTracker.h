@@ -0,0 +1,86 @@
+#ifndef LATENCYTRACKER_H__
+#define LATENCYTRACKER_H__
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "utils.h"
+
+// Measures how long a key press takes to become visible on screen.
+//
+// A press is timestamped when GLUT delivers it to GameManager, tagged with
+// the first simulation tick that reads it through WorldBase::GetKey() or
+// GetKeyDown(), and closed by the first Display() that swaps a frame produced
+// by that tick or a later one. Note that glutSwapBuffers() may return before
+// the frame is actually scanned out, so "present" is a lower bound of the
+// visible latency. Presses, ticks and presents may come from different
+// threads.
+class LatencyTracker {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // 1 ms buckets, the last one collects everything above.
+  class Histogram {
+  public:
+    static constexpr int BUCKETS = 250;
+
+    Histogram();
+    void Add(double ms);
+    int GetCount() const;
+    double GetMax() const;
+    // Upper edge (in ms) of the bucket containing the given percentile.
+    double Percentile(double p) const;
+    void Print(std::ostream& out, const char* name) const;
+    void PrintBuckets(std::ostream& out) const;
+
+  private:
+    std::array<int, BUCKETS + 1> m_buckets;
+    int m_count;
+    double m_max;
+  };
+
+  LatencyTracker();
+
+  void Enable(const std::string& logPath);
+  bool IsEnabled() const;
+
+  void OnKeyDown(KeyCode key);
+  void OnKeyUp(KeyCode key);
+  void OnTick();
+  // The tick a frame captured now belongs to.
+  long long GetTick() const;
+  void OnKeyConsumed(KeyCode key);
+  // The key was read by something other than the simulation, e.g. to answer
+  // a prompt; its press is forgotten without being timed or dropped.
+  void OnKeyIgnored(KeyCode key);
+  // A frame captured at tick has been swapped.
+  void OnFramePresented(long long tick);
+
+  // Writes the histograms to the log file given to Enable().
+  void Report() const;
+
+private:
+  struct PendingPress {
+    KeyCode key;
+    Clock::time_point pressed;
+    Clock::time_point consumed;
+    long long consumedTick;
+  };
+
+  static double ElapsedMs(Clock::time_point from, Clock::time_point to);
+
+  mutable std::mutex m_mutex;
+  bool m_enabled;
+  std::string m_logPath;
+  long long m_tick;
+  int m_dropped;
+  std::vector<PendingPress> m_pending;
+  Histogram m_keyToTick;
+  Histogram m_keyToPresent;
+};
+
+#endif // !LATENCYTRACKER_H__
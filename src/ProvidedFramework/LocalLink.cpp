@@ -0,0 +1,131 @@
+#include "LocalLink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+LocalLink::LocalLink()
+  : m_socket(-1), m_remotePort(0), m_delayMs(0), m_jitterMs(0), m_lossPercent(0),
+    m_delayed(), m_random(std::random_device()()) {}
+
+LocalLink::~LocalLink() {
+#ifndef _WIN32
+  if (m_socket >= 0) {
+    close(m_socket);
+  }
+#endif
+}
+
+bool LocalLink::Open(unsigned short localPort, unsigned short remotePort) {
+#ifndef _WIN32
+  m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+  if (m_socket < 0) {
+    std::cerr << "Cannot create socket: " << strerror(errno) << std::endl;
+    return false;
+  }
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(localPort);
+  if (bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+    std::cerr << "Cannot listen on port " << localPort << ": " << strerror(errno) << std::endl;
+    close(m_socket);
+    m_socket = -1;
+    return false;
+  }
+  fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL, 0) | O_NONBLOCK);
+  m_remotePort = remotePort;
+  return true;
+#else
+  (void)localPort;
+  (void)remotePort;
+  std::cerr << "Local links are only supported on POSIX systems" << std::endl;
+  return false;
+#endif
+}
+
+bool LocalLink::IsOpen() const {
+  return m_socket >= 0;
+}
+
+void LocalLink::SetImpairment(int delayMs, int jitterMs, int lossPercent) {
+  m_delayMs = delayMs;
+  m_jitterMs = jitterMs;
+  m_lossPercent = lossPercent;
+}
+
+void LocalLink::Send(const unsigned char* data, size_t size) {
+  FlushDelayed();
+  if (m_lossPercent > 0 && std::uniform_int_distribution<int>(0, 99)(m_random) < m_lossPercent) {
+    return;
+  }
+  if (m_delayMs <= 0 && m_jitterMs <= 0) {
+    SendNow(data, size);
+    return;
+  }
+  int jitter = m_jitterMs > 0 ? std::uniform_int_distribution<int>(-m_jitterMs, m_jitterMs)(m_random) : 0;
+  Delayed delayed;
+  delayed.due = Clock::now() + std::chrono::milliseconds(std::max(0, m_delayMs + jitter));
+  delayed.data.assign(data, data + size);
+  m_delayed.push_back(std::move(delayed));
+}
+
+bool LocalLink::Receive(std::vector<unsigned char>& datagram) {
+  FlushDelayed();
+#ifndef _WIN32
+  if (m_socket < 0) {
+    return false;
+  }
+  datagram.resize(MAX_DATAGRAM);
+  ssize_t size = recv(m_socket, datagram.data(), datagram.size(), 0);
+  if (size < 0) {
+    datagram.clear();
+    return false;
+  }
+  datagram.resize(static_cast<size_t>(size));
+  return true;
+#else
+  return false;
+#endif
+}
+
+void LocalLink::SendNow(const unsigned char* data, size_t size) {
+#ifndef _WIN32
+  if (m_socket < 0) {
+    return;
+  }
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(m_remotePort);
+  // Nobody listening yet is not an error, the datagram is just lost.
+  sendto(m_socket, data, size, 0, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+#else
+  (void)data;
+  (void)size;
+#endif
+}
+
+void LocalLink::FlushDelayed() {
+  // Jitter lets later datagrams overtake earlier ones, like on a real network.
+  Clock::time_point now = Clock::now();
+  for (auto it = m_delayed.begin(); it != m_delayed.end(); ) {
+    if (it->due <= now) {
+      SendNow(it->data.data(), it->data.size());
+      it = m_delayed.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
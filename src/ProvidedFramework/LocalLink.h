@@ -0,0 +1,54 @@
+#ifndef LOCALLINK_H__
+#define LOCALLINK_H__
+
+#include <chrono>
+#include <deque>
+#include <random>
+#include <vector>
+
+// A UDP link between two processes on the same machine (127.0.0.1).
+//
+// Datagrams may be lost, duplicated or reordered, so whatever runs on top
+// has to cope; to test that on loopback, SetImpairment() holds outgoing
+// datagrams back by a delay with jitter and drops a share of them.
+// Only available on POSIX systems; elsewhere Open() fails.
+class LocalLink {
+public:
+  static const size_t MAX_DATAGRAM = 1024;
+
+  LocalLink();
+  ~LocalLink();
+  LocalLink(const LocalLink& other) = delete;
+  LocalLink& operator=(const LocalLink& other) = delete;
+
+  // Listens on localPort and sends to remotePort.
+  bool Open(unsigned short localPort, unsigned short remotePort);
+  bool IsOpen() const;
+
+  void SetImpairment(int delayMs, int jitterMs, int lossPercent);
+
+  void Send(const unsigned char* data, size_t size);
+  // Never blocks; false when nothing has arrived.
+  bool Receive(std::vector<unsigned char>& datagram);
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Delayed {
+    Clock::time_point due;
+    std::vector<unsigned char> data;
+  };
+
+  void SendNow(const unsigned char* data, size_t size);
+  void FlushDelayed();
+
+  int m_socket;
+  unsigned short m_remotePort;
+  int m_delayMs;
+  int m_jitterMs;
+  int m_lossPercent;
+  std::deque<Delayed> m_delayed;
+  std::mt19937 m_random;
+};
+
+#endif // !LOCALLINK_H__
@@ -0,0 +1,147 @@
+#include "MemoryTracker.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+MemoryTracker::MemoryTracker() : m_tagMutex(), m_tagCount(0), m_names(), m_inTotal(), m_stats(), m_local() {
+  for (auto& stats : m_stats) {
+    stats.liveBytes = 0;
+    stats.liveCount = 0;
+    stats.peakBytes = 0;
+    stats.totalCount = 0;
+  }
+}
+
+int MemoryTracker::RegisterTag(const std::string& name, bool inTotal) {
+  std::lock_guard<std::mutex> lock(m_tagMutex);
+  for (int i = 0; i < m_tagCount; i++) {
+    if (m_names[i] == name) {
+      return i;
+    }
+  }
+  if (m_tagCount == OTHER_TAG) {
+    // Out of tags, lump the rest together.
+    m_names[OTHER_TAG] = "other";
+    m_inTotal[OTHER_TAG] = true;
+    return OTHER_TAG;
+  }
+  m_names[m_tagCount] = name;
+  m_inTotal[m_tagCount] = inTotal;
+  return m_tagCount++;
+}
+
+void MemoryTracker::Allocate(int tag, size_t bytes) {
+  TagStats& stats = m_stats[tag];
+  long long live = stats.liveBytes += static_cast<long long>(bytes);
+  stats.liveCount++;
+  stats.totalCount++;
+  long long peak = stats.peakBytes.load(std::memory_order_relaxed);
+  while (live > peak && !stats.peakBytes.compare_exchange_weak(peak, live)) {}
+}
+
+void MemoryTracker::Deallocate(int tag, size_t bytes) {
+  TagStats& stats = m_stats[tag];
+  stats.liveBytes -= static_cast<long long>(bytes);
+  stats.liveCount--;
+}
+
+void MemoryTracker::Attach(LocalCounts* counts) {
+  std::lock_guard<std::mutex> lock(m_tagMutex);
+  m_local.push_back(counts);
+}
+
+void MemoryTracker::Detach(LocalCounts* counts) {
+  std::lock_guard<std::mutex> lock(m_tagMutex);
+  for (int i = 0; i < MAX_TAGS; i++) {
+    const LocalCounts::Counts& local = counts->m_counts[i];
+    if (local.totalCount == 0) continue;
+    Totals totals = GetTotals(i);
+    m_stats[i].peakBytes = totals.peakBytes;
+    m_stats[i].liveBytes += local.liveBytes;
+    m_stats[i].liveCount += local.liveCount;
+    m_stats[i].totalCount += local.totalCount;
+  }
+  m_local.erase(std::find(m_local.begin(), m_local.end(), counts));
+}
+
+MemoryTracker::Totals MemoryTracker::GetTotals(int tag) const {
+  TagStats& stats = m_stats[tag];
+  Totals totals{ stats.liveBytes, stats.liveCount, 0, stats.totalCount };
+  for (const LocalCounts* local : m_local) {
+    const LocalCounts::Counts& counts = local->m_counts[tag];
+    totals.liveBytes += counts.liveBytes.load(std::memory_order_relaxed);
+    totals.liveCount += counts.liveCount.load(std::memory_order_relaxed);
+    totals.totalCount += counts.totalCount.load(std::memory_order_relaxed);
+  }
+  long long peak = stats.peakBytes.load(std::memory_order_relaxed);
+  while (totals.liveBytes > peak && !stats.peakBytes.compare_exchange_weak(peak, totals.liveBytes)) {}
+  totals.peakBytes = std::max(peak, totals.liveBytes);
+  return totals;
+}
+
+long long MemoryTracker::GetLiveBytes() const {
+  std::lock_guard<std::mutex> lock(m_tagMutex);
+  return GetLiveBytesLocked();
+}
+
+long long MemoryTracker::GetLiveBytesLocked() const {
+  long long total = 0;
+  for (int i = 0; i < MAX_TAGS; i++) {
+    if (m_inTotal[i]) {
+      total += GetTotals(i).liveBytes;
+    }
+  }
+  return total;
+}
+
+void MemoryTracker::Dump(std::ostream& out, long long tick) const {
+  std::lock_guard<std::mutex> lock(m_tagMutex);
+  out << "# tick " << tick << ", " << GetLiveBytesLocked() << " live bytes\n";
+  for (int i = 0; i < MAX_TAGS; i++) {
+    if (m_names[i].empty()) continue;
+    Totals totals = GetTotals(i);
+    out << tick << "," << m_names[i] << "," << totals.liveBytes << "," << totals.liveCount
+        << "," << totals.peakBytes << "," << totals.totalCount << "\n";
+  }
+  out.flush();
+}
+
+std::string MemoryTracker::Summary() const {
+  std::lock_guard<std::mutex> lock(m_tagMutex);
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(1) << "Memory: " << GetLiveBytesLocked() / 1024.0 << " KiB";
+  for (int i = 0; i < MAX_TAGS; i++) {
+    if (m_names[i].empty()) continue;
+    long long live = GetTotals(i).liveBytes;
+    if (live == 0) continue;
+    line << "   " << m_names[i] << " " << live / 1024.0;
+  }
+  return line.str();
+}
+
+MemoryTracker::LocalCounts::LocalCounts() : m_counts() {
+  for (auto& counts : m_counts) {
+    counts.liveBytes = 0;
+    counts.liveCount = 0;
+    counts.totalCount = 0;
+  }
+  MemoryTracker::Instance().Attach(this);
+}
+
+MemoryTracker::LocalCounts::~LocalCounts() {
+  MemoryTracker::Instance().Detach(this);
+}
+
+void MemoryTracker::LocalCounts::Allocate(int tag, size_t bytes) {
+  Counts& counts = m_counts[tag];
+  Add(counts.liveBytes, static_cast<long long>(bytes));
+  Add(counts.liveCount, 1);
+  Add(counts.totalCount, 1);
+}
+
+void MemoryTracker::LocalCounts::Deallocate(int tag, size_t bytes) {
+  Counts& counts = m_counts[tag];
+  Add(counts.liveBytes, -static_cast<long long>(bytes));
+  Add(counts.liveCount, -1);
+}
@@ -0,0 +1,179 @@
+#ifndef MEMORYTRACKER_H__
+#define MEMORYTRACKER_H__
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Attributes live bytes and allocation counts to named tags.
+//
+// Containers opt in with TrackingAllocator, everything else (GL textures,
+// object pool chunks) reports through Allocate()/Deallocate() directly.
+// Counters are atomic so worlds stepped on other threads can report too.
+// Tags hit on every object spawn count in a LocalCounts instead, which the
+// tracker adds up when it reports.
+class MemoryTracker {
+public:
+  static const int MAX_TAGS = 32;
+
+  // Counters written by a single thread, so counting never contends with
+  // other worlds. They attach to the tracker for their lifetime; on the way
+  // out whatever they counted is folded into the shared counters. Peaks of
+  // tags counted here are sampled when the tracker reports.
+  class LocalCounts {
+  public:
+    LocalCounts();
+    ~LocalCounts();
+    LocalCounts(const LocalCounts& other) = delete;
+    LocalCounts& operator=(const LocalCounts& other) = delete;
+
+    void Allocate(int tag, size_t bytes);
+    void Deallocate(int tag, size_t bytes);
+
+  private:
+    friend class MemoryTracker;
+
+    // Only the owning thread writes, so a relaxed load and store is enough.
+    static void Add(std::atomic<long long>& counter, long long delta) {
+      counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    struct Counts {
+      std::atomic<long long> liveBytes;
+      std::atomic<long long> liveCount;
+      std::atomic<long long> totalCount;
+    };
+    std::array<Counts, MAX_TAGS> m_counts;
+  };
+
+  // Mayers' singleton pattern
+  MemoryTracker(const MemoryTracker& other) = delete;
+  MemoryTracker& operator=(const MemoryTracker& other) = delete;
+  static MemoryTracker& Instance() { static MemoryTracker instance; return instance; }
+
+  // Returns the id of the tag with that name, registering it on first use.
+  // Once MAX_TAGS - 1 tags exist, new names share a last tag named "other".
+  // Tags counting bytes that already sit inside another tag's allocations
+  // (objects in pool chunks) pass inTotal = false: they are listed, but
+  // left out of the live byte totals.
+  int RegisterTag(const std::string& name, bool inTotal = true);
+
+  void Allocate(int tag, size_t bytes);
+  void Deallocate(int tag, size_t bytes);
+
+  long long GetLiveBytes() const;
+
+  // One line per tag: live bytes, live allocations, peak bytes, total allocations.
+  void Dump(std::ostream& out, long long tick) const;
+  // Short single-line summary for the overlay.
+  std::string Summary() const;
+
+private:
+  struct TagStats {
+    std::atomic<long long> liveBytes;
+    std::atomic<long long> liveCount;
+    std::atomic<long long> peakBytes;
+    std::atomic<long long> totalCount;
+  };
+
+  // A tag's shared counters plus those of every attached LocalCounts.
+  struct Totals {
+    long long liveBytes;
+    long long liveCount;
+    long long peakBytes;
+    long long totalCount;
+  };
+
+  static const int OTHER_TAG = MAX_TAGS - 1;
+
+  MemoryTracker();
+
+  void Attach(LocalCounts* counts);
+  void Detach(LocalCounts* counts);
+  // With m_tagMutex held.
+  Totals GetTotals(int tag) const;
+  long long GetLiveBytesLocked() const;
+
+  mutable std::mutex m_tagMutex;
+  int m_tagCount;
+  // Empty for tags not registered, "other" only once a name fell into it.
+  std::array<std::string, MAX_TAGS> m_names;
+  std::array<bool, MAX_TAGS> m_inTotal;
+  // Peaks of locally counted tags are raised when read.
+  mutable std::array<TagStats, MAX_TAGS> m_stats;
+  std::vector<LocalCounts*> m_local;
+};
+
+// A tag type provides "static int Id()", usually a function-local static
+// holding MemoryTracker::Instance().RegisterTag("name").
+template<typename T, typename Tag>
+class TrackingAllocator {
+public:
+  using value_type = T;
+
+  template<typename U>
+  struct rebind { using other = TrackingAllocator<U, Tag>; };
+
+  TrackingAllocator() noexcept {}
+  template<typename U>
+  TrackingAllocator(const TrackingAllocator<U, Tag>&) noexcept {}
+
+  T* allocate(size_t n) {
+    T* p = std::allocator<T>().allocate(n);
+    MemoryTracker::Instance().Allocate(Tag::Id(), n * sizeof(T));
+    return p;
+  }
+
+  void deallocate(T* p, size_t n) noexcept {
+    MemoryTracker::Instance().Deallocate(Tag::Id(), n * sizeof(T));
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  template<typename U>
+  bool operator==(const TrackingAllocator<U, Tag>&) const noexcept { return true; }
+  template<typename U>
+  bool operator!=(const TrackingAllocator<U, Tag>&) const noexcept { return false; }
+};
+
+struct RenderRegistryMemTag {
+  static int Id() { static int id = MemoryTracker::Instance().RegisterTag("render registry"); return id; }
+};
+
+struct ParticleMemTag {
+  static int Id() { static int id = MemoryTracker::Instance().RegisterTag("particles"); return id; }
+};
+
+struct SpriteMemTag {
+  static int Id() { static int id = MemoryTracker::Instance().RegisterTag("sprites"); return id; }
+};
+
+struct TraceMemTag {
+  static int Id() { static int id = MemoryTracker::Instance().RegisterTag("trace"); return id; }
+};
+
+struct HudMemTag {
+  static int Id() { static int id = MemoryTracker::Instance().RegisterTag("hud strings"); return id; }
+};
+
+struct TextMemTag {
+  static int Id() { static int id = MemoryTracker::Instance().RegisterTag("text"); return id; }
+};
+
+struct DrawMemTag {
+  static int Id() { static int id = MemoryTracker::Instance().RegisterTag("draw snapshots"); return id; }
+};
+
+struct CaptureMemTag {
+  static int Id() { static int id = MemoryTracker::Instance().RegisterTag("frame capture"); return id; }
+};
+
+struct TelemetryMemTag {
+  static int Id() { static int id = MemoryTracker::Instance().RegisterTag("telemetry"); return id; }
+};
+
+#endif // !MEMORYTRACKER_H__
@@ -1,9 +1,19 @@
 #include "ObjectBase.h"
-#include "GameManager.h"
+
+#include <cstdlib>
+
+#include "WorldBase.h"
 
 ObjectBase::ObjectBase(int imageID, int x, int y, int direction, int layer, double size)
-  : m_imageID(imageID), m_x(x), m_y(y), m_direction(direction), m_layer(layer), m_size(size) {
-  GetObjects(m_layer).insert(this);
+  : m_x(static_cast<int16_t>(x)), m_y(static_cast<int16_t>(y)), m_size(static_cast<float>(size)), m_registrySlot(NOT_REGISTERED),
+    m_direction(static_cast<int16_t>(direction % 360)), m_imageID(static_cast<uint8_t>(imageID)),
+    m_layer(static_cast<uint8_t>(layer < MAX_LAYERS ? layer : 0)) {
+  WorldBase* world = WorldBase::Current();
+  if (world != nullptr) {
+    RenderRegistry::Objects& objects = world->GetContext().registry.GetObjects(m_layer);
+    m_registrySlot = static_cast<uint32_t>(objects.size());
+    objects.push_back(this);
+  }
 }
 
 //ObjectBase::ObjectBase(const ObjectBase& other)
@@ -41,7 +51,27 @@ ObjectBase::ObjectBase(int imageID, int x, int y, int direction, int layer, doub
 //}
 
 ObjectBase::~ObjectBase() {
-  GetObjects(m_layer).erase(this);
+  if (m_registrySlot == NOT_REGISTERED) {
+    return;
+  }
+  WorldBase* world = WorldBase::Current();
+  if (world == nullptr) {
+    std::cerr << "ObjectBase destroyed outside a WorldBase::Scope while still registered" << std::endl;
+    std::abort();
+  }
+  Unregister(world->GetContext().registry);
+}
+
+void ObjectBase::Unregister(RenderRegistry& registry) {
+  if (m_registrySlot == NOT_REGISTERED) {
+    return;
+  }
+  RenderRegistry::Objects& objects = registry.GetObjects(m_layer);
+  ObjectBase* last = objects.back();
+  objects[m_registrySlot] = last;
+  last->m_registrySlot = m_registrySlot;
+  objects.pop_back();
+  m_registrySlot = NOT_REGISTERED;
 }
 
 bool ObjectBase::operator==(const ObjectBase& other) {
@@ -69,24 +99,14 @@ double ObjectBase::GetSize() const {
 }
 
 void ObjectBase::MoveTo(int x, int y) {
-  m_x = x;
-  m_y = y;
+  m_x = static_cast<int16_t>(x);
+  m_y = static_cast<int16_t>(y);
 }
 
 void ObjectBase::SetDirection(int direction) {
-  m_direction = direction % 360;
+  m_direction = static_cast<int16_t>(direction % 360);
 }
 
 void ObjectBase::SetSize(double size) {
-  m_size = size;
-}
-
-std::set<ObjectBase*>& ObjectBase::GetObjects(int layer) {
-  static std::set<ObjectBase*> gameObjects[MAX_LAYERS];
-  if (layer < MAX_LAYERS) {
-    return gameObjects[layer];
-  }
-  else {
-    return gameObjects[0];
-  }
+  m_size = static_cast<float>(size);
 }
@@ -1,10 +1,13 @@
 #ifndef OBJECTBASE_H__
 #define OBJECTBASE_H__
 
+#include <cstdint>
 #include <iostream>
-#include <set>
+#include <vector>
 
 #include "utils.h"
+#include "MemoryTracker.h"
+#include "WorldContext.h"
 
 class ObjectBase {
 public:
@@ -29,25 +32,43 @@ public:
   void SetDirection(int direction);
   void SetSize(double size);
 
+protected:
+  // Takes the object out of the registry it joined on construction. Objects
+  // that know their world call this from their destructor; anything still
+  // registered by ~ObjectBase leaves the registry of the current world.
+  void Unregister(RenderRegistry& registry);
+
 private:
-  int m_imageID;
-  int m_x;
-  int m_y;
-  int m_direction;
-  int m_layer;
-  double m_size;
+  // Packed into 24 bytes with the vtable pointer so that GameObject's hot
+  // fields still share the first cache line; coordinates stay well within
+  // int16 since objects die soon after leaving the window.
+  int16_t m_x;
+  int16_t m_y;
+  float m_size;
+  // Position inside the registry for m_layer of the world current at
+  // construction, so unregistering is a swap-remove; NOT_REGISTERED outside
+  // any world.
+  uint32_t m_registrySlot;
+  int16_t m_direction;
+  uint8_t m_imageID;
+  uint8_t m_layer;
+
+  static const uint32_t NOT_REGISTERED = ~0u;
 
 public:
   template<typename Func>
-  static void DisplayAllObjects(Func displayFunc) {
+  static void DisplayAllObjects(const RenderRegistry& registry, Func displayFunc) {
     for (int layer = MAX_LAYERS - 1; layer >= 0; layer--) {
-      for (auto& obj : GetObjects(layer)) {
-        displayFunc(obj->m_imageID, obj->m_x, obj->m_y, obj->m_direction, obj->m_size);
-      }
+      DisplayLayer(registry, layer, displayFunc);
+    }
+  }
+
+  template<typename Func>
+  static void DisplayLayer(const RenderRegistry& registry, int layer, Func displayFunc) {
+    for (auto& obj : registry.GetObjects(layer)) {
+      displayFunc(obj->m_imageID, obj->m_x, obj->m_y, obj->m_direction, obj->m_size);
     }
   }
-private:
-  static std::set<ObjectBase*>& GetObjects(int layer);
 
 };
 
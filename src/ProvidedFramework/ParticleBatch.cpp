@@ -0,0 +1,94 @@
+#include "ParticleBatch.h"
+
+#include <algorithm>
+
+ParticleBatch::ParticleBatch(RenderRegistry& registry, int imageID, int layer, size_t capacity)
+  : m_registry(registry), m_imageID(imageID), m_layer(layer < MAX_LAYERS ? layer : 0), m_capacity(capacity),
+    m_first(0), m_count(0), m_offsetX(0.0f), m_offsetY(0.0f), m_x(2 * capacity), m_y(2 * capacity),
+    m_size(2 * capacity) {
+  m_registry.GetBatches(m_layer).push_back(this);
+}
+
+ParticleBatch::~ParticleBatch() {
+  RenderRegistry::Batches& batches = m_registry.GetBatches(m_layer);
+  batches.erase(std::remove(batches.begin(), batches.end(), this), batches.end());
+}
+
+int ParticleBatch::GetImageID() const {
+  return m_imageID;
+}
+
+int ParticleBatch::GetLayer() const {
+  return m_layer;
+}
+
+size_t ParticleBatch::GetCount() const {
+  return m_count;
+}
+
+size_t ParticleBatch::GetCapacity() const {
+  return m_capacity;
+}
+
+void ParticleBatch::SetCapacity(size_t capacity) {
+  m_capacity = capacity;
+  m_first = 0;
+  m_count = 0;
+  Buffer(2 * capacity).swap(m_x);
+  Buffer(2 * capacity).swap(m_y);
+  Buffer(2 * capacity).swap(m_size);
+}
+
+int ParticleBatch::Add(float x, float y, float size) {
+  return Insert(m_count, x, y, size);
+}
+
+int ParticleBatch::Insert(size_t i, float x, float y, float size) {
+  if (m_count == m_capacity) {
+    return -1;
+  }
+  if (m_first + m_count == m_x.size()) {
+    Compact();
+  }
+  size_t at = m_first + i;
+  size_t end = m_first + m_count;
+  std::copy_backward(m_x.begin() + at, m_x.begin() + end, m_x.begin() + end + 1);
+  std::copy_backward(m_y.begin() + at, m_y.begin() + end, m_y.begin() + end + 1);
+  std::copy_backward(m_size.begin() + at, m_size.begin() + end, m_size.begin() + end + 1);
+  m_x[at] = x;
+  m_y[at] = y;
+  m_size[at] = size;
+  m_count++;
+  return static_cast<int>(i);
+}
+
+void ParticleBatch::Remove(size_t i) {
+  m_count--;
+  m_x[m_first + i] = m_x[m_first + m_count];
+  m_y[m_first + i] = m_y[m_first + m_count];
+  m_size[m_first + i] = m_size[m_first + m_count];
+}
+
+void ParticleBatch::RemoveFront(size_t n) {
+  m_count -= n;
+  m_first = m_count == 0 ? 0 : m_first + n;
+}
+
+void ParticleBatch::Clear() {
+  m_first = 0;
+  m_count = 0;
+}
+
+void ParticleBatch::SetOffset(float x, float y) {
+  m_offsetX = x;
+  m_offsetY = y;
+}
+
+void ParticleBatch::Compact() {
+  // At most once every m_capacity removals from the front, as the storage
+  // holds twice as many particles as the batch.
+  std::copy(m_x.begin() + m_first, m_x.begin() + m_first + m_count, m_x.begin());
+  std::copy(m_y.begin() + m_first, m_y.begin() + m_first + m_count, m_y.begin());
+  std::copy(m_size.begin() + m_first, m_size.begin() + m_first + m_count, m_size.begin());
+  m_first = 0;
+}
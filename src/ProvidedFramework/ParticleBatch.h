@@ -0,0 +1,89 @@
+#ifndef PARTICLEBATCH_H__
+#define PARTICLEBATCH_H__
+
+#include <cstddef>
+#include <vector>
+
+#include "utils.h"
+#include "MemoryTracker.h"
+#include "WorldContext.h"
+
+// A fixed-capacity set of unrotated sprites sharing one image and layer,
+// stored as parallel arrays. GameManager draws a whole batch with a single
+// texture bind and a single glBegin/glEnd, so thousands of particles cost
+// about as much as one ObjectBase. Batches register per layer in their
+// world's registry and are drawn before the objects of the same layer.
+//
+// A batch whose particles all move alike moves by its offset alone: every
+// particle is drawn at its position plus the offset, which is then the only
+// thing written per tick. Kept in order, such particles also leave from the
+// front, so RemoveFront() slides a head index instead of touching the rest;
+// storage is twice the capacity for the head to run into.
+class ParticleBatch {
+public:
+  ParticleBatch(RenderRegistry& registry, int imageID, int layer, size_t capacity);
+  ParticleBatch(const ParticleBatch& other) = delete;
+  ParticleBatch& operator=(const ParticleBatch& other) = delete;
+  ~ParticleBatch();
+
+  int GetImageID() const;
+  int GetLayer() const;
+  size_t GetCount() const;
+  size_t GetCapacity() const;
+  // Drops all particles and changes the capacity.
+  void SetCapacity(size_t capacity);
+
+  // Returns the index of the new particle, or -1 when the batch is full.
+  int Add(float x, float y, float size);
+  // Inserts at index i, moving the particles from i on up by one, and
+  // returns i, or -1 when the batch is full.
+  int Insert(size_t i, float x, float y, float size);
+  // Swap-removes: the last particle takes index i.
+  void Remove(size_t i);
+  // Removes the first n particles; the others keep their order.
+  void RemoveFront(size_t n);
+  // Removes all particles; the offset is kept.
+  void Clear();
+
+  // Added to every position when the batch is drawn.
+  void SetOffset(float x, float y);
+  float GetOffsetX() const { return m_offsetX; }
+  float GetOffsetY() const { return m_offsetY; }
+
+  float* GetX() { return m_x.data() + m_first; }
+  float* GetY() { return m_y.data() + m_first; }
+  float* GetSize() { return m_size.data() + m_first; }
+  const float* GetX() const { return m_x.data() + m_first; }
+  const float* GetY() const { return m_y.data() + m_first; }
+  const float* GetSize() const { return m_size.data() + m_first; }
+
+  template<typename Func>
+  static void DisplayLayer(const RenderRegistry& registry, int layer, Func displayFunc) {
+    for (auto& batch : registry.GetBatches(layer)) {
+      if (batch->m_count > 0) {
+        displayFunc(*batch);
+      }
+    }
+  }
+
+private:
+  using Buffer = std::vector<float, TrackingAllocator<float, ParticleMemTag>>;
+
+  // Makes room at the end by moving the particles back to index 0.
+  void Compact();
+
+  RenderRegistry& m_registry;
+  int m_imageID;
+  int m_layer;
+  size_t m_capacity;
+  // Where particle 0 is stored.
+  size_t m_first;
+  size_t m_count;
+  float m_offsetX;
+  float m_offsetY;
+  Buffer m_x;
+  Buffer m_y;
+  Buffer m_size;
+};
+
+#endif // !PARTICLEBATCH_H__
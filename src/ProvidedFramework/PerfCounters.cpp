@@ -0,0 +1,207 @@
+#include "PerfCounters.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+PerfCounters::PerfCounters()
+  : m_enabled(false), m_owner(), m_groupFd(-1), m_slot(), m_fds(), m_opened(0), m_phases() {
+  m_slot.fill(-1);
+  m_fds.fill(-1);
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+  for (int fd : m_fds) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+#endif
+}
+
+#ifdef __linux__
+static int OpenCounter(unsigned int type, unsigned long long config, int groupFd) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = groupFd < 0 ? 1 : 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+#endif
+
+bool PerfCounters::Enable() {
+#ifdef __linux__
+  if (m_enabled) {
+    return true;
+  }
+  const unsigned long long l1dReadMiss = PERF_COUNT_HW_CACHE_L1D
+    | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  const struct { unsigned int type; unsigned long long config; } events[COUNTER_COUNT] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, l1dReadMiss },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  };
+
+  // Cycles lead the group so all counters are scheduled together and one
+  // read() returns them all.
+  m_groupFd = OpenCounter(events[CYCLES].type, events[CYCLES].config, -1);
+  if (m_groupFd < 0) {
+    std::cerr << "Hardware counters unavailable: " << strerror(errno);
+    if (errno == EACCES || errno == EPERM) {
+      std::cerr << " (see /proc/sys/kernel/perf_event_paranoid)";
+    } else if (errno == ENOENT || errno == ENODEV) {
+      std::cerr << " (no hardware PMU, e.g. in a virtual machine)";
+    }
+    std::cerr << std::endl;
+    return false;
+  }
+  m_fds[CYCLES] = m_groupFd;
+  m_slot[CYCLES] = 0;
+  m_opened = 1;
+  for (int counter = CYCLES + 1; counter < COUNTER_COUNT; counter++) {
+    int fd = OpenCounter(events[counter].type, events[counter].config, m_groupFd);
+    if (fd < 0) {
+      continue;
+    }
+    m_fds[counter] = fd;
+    m_slot[counter] = m_opened++;
+  }
+
+  ioctl(m_groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(m_groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  m_owner = std::this_thread::get_id();
+  m_enabled = true;
+  return true;
+#else
+  std::cerr << "Hardware counters are only supported on Linux" << std::endl;
+  return false;
+#endif
+}
+
+bool PerfCounters::Read(Values& values) const {
+#ifdef __linux__
+  // nr followed by one value per opened counter, in opening order.
+  unsigned long long buffer[1 + COUNTER_COUNT];
+  ssize_t bytes = read(m_groupFd, buffer, sizeof(buffer));
+  if (bytes < static_cast<ssize_t>(sizeof(unsigned long long) * (1 + m_opened))) {
+    return false;
+  }
+  for (int counter = 0; counter < COUNTER_COUNT; counter++) {
+    values[counter] = m_slot[counter] >= 0 ? buffer[1 + m_slot[counter]] : 0;
+  }
+  return true;
+#else
+  (void)values;
+  return false;
+#endif
+}
+
+void PerfCounters::Begin(Phase phase) {
+  if (!m_enabled || !OwnerThread()) {
+    return;
+  }
+  Read(m_phases[static_cast<int>(phase)].start);
+}
+
+void PerfCounters::End(Phase phase, size_t objects) {
+  if (!m_enabled || !OwnerThread()) {
+    return;
+  }
+  Values now;
+  if (!Read(now)) {
+    return;
+  }
+  PhaseStats& stats = m_phases[static_cast<int>(phase)];
+  for (int counter = 0; counter < COUNTER_COUNT; counter++) {
+    stats.totals[counter] += now[counter] - stats.start[counter];
+  }
+  stats.calls++;
+  stats.objects += objects;
+}
+
+void PerfCounters::Reset() {
+  for (PhaseStats& stats : m_phases) {
+    stats = PhaseStats();
+  }
+}
+
+const char* PerfCounters::PhaseName(Phase phase) {
+  switch (phase) {
+  case Phase::TICK:
+    return "tick";
+  case Phase::SPAWN:
+    return "spawn";
+  case Phase::OBJECTS:
+    return "objects";
+  case Phase::PARTICLES:
+    return "particles";
+  case Phase::COMPACT:
+    return "compact";
+  case Phase::RENDER:
+    return "render";
+  default:
+    return "?";
+  }
+}
+
+void PerfCounters::Report(std::ostream& out) const {
+  if (!m_enabled) {
+    return;
+  }
+  static const char* const names[COUNTER_COUNT] = { "cycles", "instr", "L1D miss", "LLC miss", "br miss" };
+
+  out << std::left << std::setw(10) << "phase" << std::right << std::setw(8) << "calls"
+      << std::setw(10) << "objects" << std::setw(7) << "IPC";
+  for (int counter = L1D_MISSES; counter < COUNTER_COUNT; counter++) {
+    if (m_slot[counter] >= 0) {
+      out << std::setw(12) << names[counter] << std::setw(8) << "/obj";
+    }
+  }
+  out << std::setw(14) << "cycles/call" << "\n";
+
+  for (int phase = 0; phase < static_cast<int>(Phase::COUNT); phase++) {
+    const PhaseStats& stats = m_phases[phase];
+    if (stats.calls == 0) {
+      continue;
+    }
+    double objects = static_cast<double>(stats.objects);
+    out << std::left << std::setw(10) << PhaseName(static_cast<Phase>(phase)) << std::right
+        << std::setw(8) << stats.calls
+        << std::setw(10) << stats.objects / stats.calls
+        << std::fixed << std::setprecision(2);
+    if (m_slot[INSTRUCTIONS] >= 0 && stats.totals[CYCLES] > 0) {
+      out << std::setw(7) << static_cast<double>(stats.totals[INSTRUCTIONS]) / stats.totals[CYCLES];
+    } else {
+      out << std::setw(7) << "-";
+    }
+    for (int counter = L1D_MISSES; counter < COUNTER_COUNT; counter++) {
+      if (m_slot[counter] < 0) {
+        continue;
+      }
+      out << std::setw(12) << stats.totals[counter] / stats.calls;
+      if (objects > 0) {
+        out << std::setw(8) << stats.totals[counter] / objects;
+      } else {
+        out << std::setw(8) << "-";
+      }
+    }
+    out << std::setw(14) << stats.totals[CYCLES] / stats.calls << "\n";
+  }
+  out.unsetf(std::ios::floatfield);
+}
@@ -0,0 +1,65 @@
+#ifndef PERFCOUNTERS_H__
+#define PERFCOUNTERS_H__
+
+#include <array>
+#include <ostream>
+#include <thread>
+
+// Attributes hardware performance counters (cycles, instructions, L1 and
+// last-level cache misses, branch misses) to the phases of a tick, so a slow
+// phase can be told apart as cache bound or branch bound.
+//
+// Counters come from Linux perf_event_open and count the thread that called
+// Enable(); phases ended on other threads are ignored. Where counters are
+// not available (other platforms, perf_event_paranoid, virtual machines
+// without a PMU) Enable() says why and everything else is a no-op. Counters
+// the CPU does not have are left out of the report.
+class PerfCounters {
+public:
+  enum class Phase { TICK, SPAWN, OBJECTS, PARTICLES, COMPACT, RENDER, COUNT };
+  enum Counter { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, COUNTER_COUNT };
+
+  // Mayers' singleton pattern
+  PerfCounters(const PerfCounters& other) = delete;
+  PerfCounters& operator=(const PerfCounters& other) = delete;
+  static PerfCounters& Instance() { static PerfCounters instance; return instance; }
+
+  // Opens the counters for the calling thread; false if none could be opened.
+  bool Enable();
+  bool IsEnabled() const { return m_enabled; }
+
+  void Begin(Phase phase);
+  // objects is how many objects the phase went through, for misses per object.
+  void End(Phase phase, size_t objects);
+
+  void Reset();
+  // Per phase: calls, IPC, misses per object and per call.
+  void Report(std::ostream& out) const;
+
+private:
+  using Values = std::array<unsigned long long, COUNTER_COUNT>;
+
+  struct PhaseStats {
+    long long calls;
+    unsigned long long objects;
+    Values totals;
+    Values start;
+  };
+
+  PerfCounters();
+  ~PerfCounters();
+  bool Read(Values& values) const;
+  bool OwnerThread() const { return std::this_thread::get_id() == m_owner; }
+  static const char* PhaseName(Phase phase);
+
+  bool m_enabled;
+  std::thread::id m_owner;
+  int m_groupFd;
+  // Position of each counter in a group read, -1 when it could not be opened.
+  std::array<int, COUNTER_COUNT> m_slot;
+  std::array<int, COUNTER_COUNT> m_fds;
+  int m_opened;
+  std::array<PhaseStats, static_cast<int>(Phase::COUNT)> m_phases;
+};
+
+#endif // !PERFCOUNTERS_H__
@@ -5,7 +5,14 @@
 #include <SOIL/SOIL.h>
 
 #include "utils.h"
+#include "TraceRecorder.h"
+#include <fstream>
 #include <iostream>
+#include <sstream>
+
+// GL 1.3 enums; the GL headers of some platforms stop at 1.1.
+static const GLenum TEXTURE_COMPRESSED = 0x86A1;
+static const GLenum TEXTURE_COMPRESSED_IMAGE_SIZE = 0x86A0;
 
 //const char* vertexSource = R"glsl(
 //	#version 330 core
@@ -35,60 +42,181 @@
 //	}
 //)glsl";
 
-SpriteManager::SpriteManager() : m_filenameMap() {
-	m_filenameMap.insert({ IMGID_DAWNBREAKER, ASSET_DIR + "dawnbreaker.png" });
-	m_filenameMap.insert({ IMGID_STAR, ASSET_DIR + "star.png" });
-	m_filenameMap.insert({ IMGID_ALPHATRON, ASSET_DIR + "alphatron.png" });
-	m_filenameMap.insert({ IMGID_SIGMATRON, ASSET_DIR + "sigmatron.png" });
-	m_filenameMap.insert({ IMGID_OMEGATRON, ASSET_DIR + "omegatron.png" });
-	m_filenameMap.insert({ IMGID_BLUE_BULLET, ASSET_DIR + "blueBullet.png" });
-	m_filenameMap.insert({ IMGID_RED_BULLET, ASSET_DIR + "redBullet.png" });
-	m_filenameMap.insert({ IMGID_EXPLOSION, ASSET_DIR + "explosion.png" });
-	m_filenameMap.insert({ IMGID_METEOR, ASSET_DIR + "meteor.png" });
-	m_filenameMap.insert({ IMGID_POWERUP_GOODIE, ASSET_DIR + "powerUpGoodie.png" });
-	m_filenameMap.insert({ IMGID_METEOR_GOODIE, ASSET_DIR + "meteorGoodie.png" });
-	m_filenameMap.insert({ IMGID_HP_RESTORE_GOODIE, ASSET_DIR + "recoveryGoodie.png" });
-	LoadSprites();
+// Names a manifest may give instead of the number, as in utils.h.
+static const struct {
+	const char* name;
+	ImageID imageID;
+} IMAGE_NAMES[] = {
+	{ "IMGID_DAWNBREAKER", IMGID_DAWNBREAKER },
+	{ "IMGID_STAR", IMGID_STAR },
+	{ "IMGID_ALPHATRON", IMGID_ALPHATRON },
+	{ "IMGID_SIGMATRON", IMGID_SIGMATRON },
+	{ "IMGID_OMEGATRON", IMGID_OMEGATRON },
+	{ "IMGID_BLUE_BULLET", IMGID_BLUE_BULLET },
+	{ "IMGID_RED_BULLET", IMGID_RED_BULLET },
+	{ "IMGID_EXPLOSION", IMGID_EXPLOSION },
+	{ "IMGID_METEOR", IMGID_METEOR },
+	{ "IMGID_POWERUP_GOODIE", IMGID_POWERUP_GOODIE },
+	{ "IMGID_METEOR_GOODIE", IMGID_METEOR_GOODIE },
+	{ "IMGID_HP_RESTORE_GOODIE", IMGID_HP_RESTORE_GOODIE },
+};
+
+SpriteManager::SpriteManager(const std::string& manifestPath) : m_sprites(), m_loaded(0), m_prefetched(-1) {
+	TraceRecorder::Scope trace("sprites", "SpriteManager::SpriteManager");
+	if (!ReadManifest(manifestPath)) {
+		std::cerr << "No sprites loaded from manifest '" << manifestPath << "'" << std::endl;
+	}
+	Prefetch(STARTUP_PRIORITY);
 }
 
-bool SpriteManager::LoadSprites(){
-	glEnable(GL_DEPTH_TEST);
-	for (auto& asset : m_filenameMap) {
-
-		int width, height;
-		unsigned char* image = SOIL_load_image(asset.second.c_str(), &width, &height, 0, SOIL_LOAD_RGBA);
-
-		//GLuint texture;
-		//glGenTextures(1, &texture);
-		//glBindTexture(GL_TEXTURE_2D, texture);
-		//glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-		////glGenerateMipmaps(GL_TEXTURE_2D);
-		//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	
-		//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		//glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		//gluBuild2DMipmaps(GL_TEXTURE_2D, 3, width, height, GL_RGB, GL_UNSIGNED_BYTE, image);
-		//SOIL_free_image_data(image);
-
-		GLuint texture = SOIL_load_OGL_texture(asset.second.c_str(), SOIL_LOAD_AUTO, SOIL_CREATE_NEW_ID,
-																					 SOIL_FLAG_MIPMAPS | SOIL_FLAG_INVERT_Y | SOIL_FLAG_COMPRESS_TO_DXT);
-		if (0 == texture) {
-			printf("SOIL loading error: '%s'\n", SOIL_last_result());
+bool SpriteManager::ParseImageID(const std::string& token, ImageID& imageID) {
+	for (auto& entry : IMAGE_NAMES) {
+		if (token == entry.name) {
+			imageID = entry.imageID;
+			return true;
 		}
+	}
+	if (token.empty() || token.find_first_not_of("0123456789") != std::string::npos || token.size() > 3) {
+		return false;
+	}
+	imageID = std::stoi(token);
+	return imageID < MAX_IMAGES;
+}
 
-		m_textureMap.insert({ asset.first, texture });
+bool SpriteManager::ReadManifest(const std::string& path) {
+	std::ifstream in(path);
+	if (!in) {
+		std::cerr << "Cannot read sprite manifest '" << path << "'" << std::endl;
+		return false;
 	}
+	// One image per line: image ID or its IMGID_ name, file in ASSET_DIR,
+	// priority. # starts a comment. Every bad line is reported before the
+	// manifest is rejected.
+	std::vector<Sprite, TrackingAllocator<Sprite, SpriteMemTag>> sprites;
+	std::string line;
+	int number = 0;
+	bool valid = true;
+	while (std::getline(in, line)) {
+		number++;
+		std::istringstream fields(line.substr(0, line.find('#')));
+		std::string token;
+		if (!(fields >> token)) {
+			continue;
+		}
+		ImageID imageID;
+		std::string file;
+		int priority;
+		std::string rest;
+		if (!ParseImageID(token, imageID)) {
+			std::cerr << path << ":" << number << ": '" << token << "' is neither an IMGID_ name nor an image ID below "
+			          << MAX_IMAGES << std::endl;
+			valid = false;
+			continue;
+		}
+		if (!(fields >> file >> priority) || (fields >> rest) || priority < 0) {
+			std::cerr << path << ":" << number << ": expected an image ID, a file and a priority" << std::endl;
+			valid = false;
+			continue;
+		}
+		if (static_cast<size_t>(imageID) >= sprites.size()) {
+			sprites.resize(imageID + 1);
+		}
+		if (!sprites[imageID].file.empty()) {
+			std::cerr << path << ":" << number << ": image ID " << imageID << " is listed twice" << std::endl;
+			valid = false;
+			continue;
+		}
+		sprites[imageID].file = ASSET_DIR + file;
+		sprites[imageID].priority = priority;
+	}
+	if (!valid) {
+		return false;
+	}
+	m_sprites.swap(sprites);
 	return true;
 }
 
-GLuint SpriteManager::GetTexture(ImageID imageID) {
-	auto it = m_textureMap.find(imageID);
-	if (it == m_textureMap.end()) {
-		return 0;
+void SpriteManager::Prefetch(int priority) {
+	if (priority <= m_prefetched) {
+		return;
+	}
+	TraceRecorder::Scope trace("sprites", "SpriteManager::Prefetch");
+	for (Sprite& sprite : m_sprites) {
+		if (!sprite.loaded && !sprite.file.empty() && sprite.priority <= priority) {
+			Load(sprite);
+		}
+	}
+	m_prefetched = priority;
+}
+
+int SpriteManager::GetLoadedCount() const {
+	return m_loaded;
+}
+
+void SpriteManager::Load(Sprite& sprite) {
+	TraceRecorder::Scope trace("sprites", "SpriteManager::Load");
+
+	//GLuint texture;
+	//glGenTextures(1, &texture);
+	//glBindTexture(GL_TEXTURE_2D, texture);
+	//glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	////glGenerateMipmaps(GL_TEXTURE_2D);
+	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	
+	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	//glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+	//gluBuild2DMipmaps(GL_TEXTURE_2D, 3, width, height, GL_RGB, GL_UNSIGNED_BYTE, image);
+	//SOIL_free_image_data(image);
+
+	GLuint texture = SOIL_load_OGL_texture(sprite.file.c_str(), SOIL_LOAD_AUTO, SOIL_CREATE_NEW_ID,
+																				 SOIL_FLAG_MIPMAPS | SOIL_FLAG_INVERT_Y | SOIL_FLAG_COMPRESS_TO_DXT);
+	if (0 == texture) {
+		printf("SOIL loading error: '%s' (%s)\n", SOIL_last_result(), sprite.file.c_str());
 	}
 	else {
-		return it->second;
+		m_loaded++;
 	}
+
+	sprite.texture = texture;
+	sprite.loaded = true;
+	MemoryTracker::Instance().Allocate(SpriteMemTag::Id(), TextureBytes(texture));
 }
 
+size_t SpriteManager::TextureBytes(GLuint texture) {
+	if (texture == 0) {
+		return 0;
+	}
+	size_t bytes = 0;
+	glBindTexture(GL_TEXTURE_2D, texture);
+	for (GLint level = 0; ; level++) {
+		GLint width = 0, height = 0, compressed = GL_FALSE;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+		if (width == 0 || height == 0) {
+			break;
+		}
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, TEXTURE_COMPRESSED, &compressed);
+		if (compressed == GL_TRUE) {
+			GLint size = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+			bytes += size;
+		}
+		else {
+			bytes += static_cast<size_t>(width) * height * 4;
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return bytes;
+}
+
+GLuint SpriteManager::GetTexture(ImageID imageID) {
+	if (imageID < 0 || static_cast<size_t>(imageID) >= m_sprites.size()) {
+		return 0;
+	}
+	Sprite& sprite = m_sprites[imageID];
+	if (!sprite.loaded && !sprite.file.empty()) {
+		Load(sprite);
+	}
+	return sprite.texture;
+}
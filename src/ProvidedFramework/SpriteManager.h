@@ -2,31 +2,68 @@
 #define SPRITEMANAGER_H__
 
 #include <string>
-#include <map>
+#include <vector>
 
 #include <GL/glut.h>
 #include <GL/freeglut.h>
 
+#include "utils.h"
+#include "MemoryTracker.h"
+
 using ImageID = int;
 
+// Textures of one GL context; GameManager creates it once the window exists.
+//
+// Which file holds each image and how soon it is needed comes from an asset
+// manifest, see assets/sprites.manifest; a missing or invalid one is
+// reported and leaves the table empty. Only images of STARTUP_PRIORITY are
+// loaded by the constructor. An image of priority N is loaded by
+// Prefetch(N), which GameManager calls while the prompt before level N is
+// up, or else the first time it is drawn. Textures sit in a table indexed by
+// ImageID.
 class SpriteManager {
 public:
-  // Mayers' singleton pattern
+  static const int STARTUP_PRIORITY = 0;
+  // ObjectBase keeps image IDs in a byte.
+  static const int MAX_IMAGES = 256;
+
+  explicit SpriteManager(const std::string& manifestPath = ASSET_DIR + "sprites.manifest");
   virtual ~SpriteManager() {}
   SpriteManager(const SpriteManager& other) = delete;
   SpriteManager& operator=(const SpriteManager& other) = delete;
-  static SpriteManager& Instance() { static SpriteManager instance; return instance; }
 
+  // Loads the image if this is its first use. 0 for an image the manifest
+  // does not list or that failed to load.
   GLuint GetTexture(ImageID imageID);
+  // Loads every image up to the given priority that is not loaded yet.
+  void Prefetch(int priority);
+  int GetLoadedCount() const;
 
 
 private:
-  SpriteManager();
+  struct Sprite {
+    std::string file;
+    int priority = 0;
+    GLuint texture = 0;
+    // Also once loading failed, so it is not retried every frame.
+    bool loaded = false;
+  };
 
-  bool LoadSprites();
+  // Replaces the table with the manifest at path; false, leaving the table
+  // untouched, if it cannot be read, a line is malformed or an image ID is
+  // listed twice.
+  bool ReadManifest(const std::string& path);
+  // A number below MAX_IMAGES or one of the IMGID_ names of utils.h.
+  static bool ParseImageID(const std::string& token, ImageID& imageID);
+  void Load(Sprite& sprite);
+  // Bytes of texture memory used by all mip levels of a texture.
+  static size_t TextureBytes(GLuint texture);
 
-  std::map<ImageID, std::string> m_filenameMap;
-  std::map<ImageID, GLuint> m_textureMap;
+  // By ImageID; images the manifest does not list have no file.
+  std::vector<Sprite, TrackingAllocator<Sprite, SpriteMemTag>> m_sprites;
+  int m_loaded;
+  // Highest priority Prefetch() went through.
+  int m_prefetched;
 
 
 };
@@ -0,0 +1,83 @@
+#ifndef SPSCRING_H__
+#define SPSCRING_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// A bounded queue from exactly one producer thread to exactly one consumer
+// thread, without locks.
+//
+// Head and tail only ever grow and are masked into the slots, so full and
+// empty are told apart without a spare slot. Each index is written by one
+// side only and sits on its own cache line; the producer keeps its own copy
+// of the tail and only reloads it when the ring looks full, so pushing
+// normally touches no line the consumer writes.
+template<typename T, typename Allocator = std::allocator<T>>
+class alignas(64) SpscRing {
+public:
+  // capacity is rounded up to a power of two.
+  explicit SpscRing(size_t capacity)
+    : m_slots(RoundUp(capacity)), m_mask(m_slots.size() - 1), m_head(0), m_cachedTail(0), m_tail(0) {}
+  SpscRing(const SpscRing& other) = delete;
+  SpscRing& operator=(const SpscRing& other) = delete;
+
+  // Producer only. Returns false, leaving the ring unchanged, when it is
+  // full.
+  bool TryPush(const T& value) {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_cachedTail == m_slots.size()) {
+      m_cachedTail = m_tail.load(std::memory_order_acquire);
+      if (head - m_cachedTail == m_slots.size()) {
+        return false;
+      }
+    }
+    m_slots[head & m_mask] = value;
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only: passes every value pushed so far to consume(const T*,
+  // size_t count), oldest first, as at most two contiguous runs, then frees
+  // their slots. Returns how many values there were.
+  template<typename Consume>
+  size_t Drain(Consume consume) {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    size_t head = m_head.load(std::memory_order_acquire);
+    size_t count = head - tail;
+    if (count == 0) {
+      return 0;
+    }
+    size_t start = tail & m_mask;
+    size_t first = std::min(count, m_slots.size() - start);
+    consume(&m_slots[start], first);
+    if (first < count) {
+      consume(&m_slots[0], count - first);
+    }
+    m_tail.store(head, std::memory_order_release);
+    return count;
+  }
+
+  size_t Capacity() const { return m_slots.size(); }
+
+private:
+  static size_t RoundUp(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+      size *= 2;
+    }
+    return size;
+  }
+
+  std::vector<T, Allocator> m_slots;
+  size_t m_mask;
+  // Written by the producer.
+  alignas(64) std::atomic<size_t> m_head;
+  size_t m_cachedTail;
+  // Written by the consumer.
+  alignas(64) std::atomic<size_t> m_tail;
+};
+
+#endif // !SPSCRING_H__
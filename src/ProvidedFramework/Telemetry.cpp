@@ -0,0 +1,165 @@
+#include "Telemetry.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "TraceRecorder.h"
+
+static_assert(sizeof(Telemetry::Record) == 24, "telemetry records are written as they are");
+static_assert(sizeof(Telemetry::FileHeader) == 16, "the telemetry header is written as it is");
+
+static const char MAGIC[4] = { 'D', 'B', 'T', 'L' };
+
+static const char* const KIND_NAMES[] = {
+  "tick", "objects", "damage", "kill", "pickup", "level_start", "level_end", "frame",
+  "governor"
+};
+static_assert(sizeof(KIND_NAMES) / sizeof(KIND_NAMES[0]) == static_cast<size_t>(Telemetry::Kind::COUNT),
+              "every kind needs a name");
+
+// The calling thread's source, owned by Telemetry::m_sources; NO_SOURCE once
+// all MAX_SOURCES are taken.
+static thread_local void* t_source = nullptr;
+static char g_noSource;
+static void* const NO_SOURCE = &g_noSource;
+
+Telemetry::Telemetry()
+  : m_enabled(false), m_start(Clock::now()), m_sources(), m_sourceCount(0), m_sourcesMutex(), m_unsourced(0),
+    m_file(), m_path(), m_written(0), m_wakeMutex(), m_wakeUp(), m_closing(false), m_writer() {
+  for (auto& source : m_sources) {
+    source.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+Telemetry::~Telemetry() {
+  Close();
+  for (auto& source : m_sources) {
+    delete source.load(std::memory_order_relaxed);
+  }
+}
+
+bool Telemetry::Enable(const std::string& path) {
+  if (IsEnabled()) {
+    return false;
+  }
+  m_file.open(path, std::ios::binary | std::ios::trunc);
+  FileHeader header;
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.recordSize = sizeof(Record);
+  header.reserved = 0;
+  if (!m_file.write(reinterpret_cast<const char*>(&header), sizeof(header))) {
+    std::cerr << "Cannot write telemetry '" << path << "'" << std::endl;
+    m_file.close();
+    return false;
+  }
+  m_path = path;
+  m_written = 0;
+  m_closing = false;
+  m_start = Clock::now();
+  m_writer = std::thread(&Telemetry::WriterLoop, this);
+  m_enabled.store(true, std::memory_order_release);
+  return true;
+}
+
+void Telemetry::Close() {
+  if (!IsEnabled()) {
+    return;
+  }
+  m_enabled.store(false, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_closing = true;
+  }
+  m_wakeUp.notify_one();
+  m_writer.join();
+  m_file.close();
+}
+
+void Telemetry::Print(std::ostream& out) const {
+  long long dropped = m_unsourced.load(std::memory_order_relaxed);
+  int count = m_sourceCount.load(std::memory_order_acquire);
+  for (int i = 0; i < count; i++) {
+    dropped += m_sources[i].load(std::memory_order_acquire)->dropped.load(std::memory_order_relaxed);
+  }
+  out << "telemetry: " << m_written << " records (" << sizeof(FileHeader) + m_written * sizeof(Record)
+      << " bytes) written to " << m_path << ", " << dropped << " dropped" << std::endl;
+}
+
+const char* Telemetry::KindName(Kind kind) {
+  return kind < Kind::COUNT ? KIND_NAMES[static_cast<int>(kind)] : "unknown";
+}
+
+bool Telemetry::Read(std::istream& in, std::vector<Record>& records) {
+  FileHeader header;
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+      || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+      || header.version != VERSION || header.recordSize != sizeof(Record)) {
+    return false;
+  }
+  // A session that crashed may end in a partly written record; it is left out.
+  Record record;
+  while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+    records.push_back(record);
+  }
+  return true;
+}
+
+void Telemetry::Push(Kind kind, int tick, int subject, int value0, int value1) {
+  Source* source = LocalSource();
+  if (source == nullptr) {
+    m_unsourced.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  Record record;
+  record.ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      Clock::now() - m_start).count());
+  record.tick = static_cast<uint32_t>(tick);
+  record.kind = static_cast<uint8_t>(kind);
+  record.source = static_cast<uint8_t>(source->index);
+  record.subject = static_cast<uint16_t>(subject);
+  record.value0 = value0;
+  record.value1 = value1;
+  if (!source->ring.TryPush(record)) {
+    source->dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+Telemetry::Source* Telemetry::LocalSource() {
+  if (t_source == nullptr) {
+    std::lock_guard<std::mutex> lock(m_sourcesMutex);
+    int index = m_sourceCount.load(std::memory_order_relaxed);
+    if (index == MAX_SOURCES) {
+      t_source = NO_SOURCE;
+    } else {
+      Source* source = new Source(index);
+      m_sources[index].store(source, std::memory_order_release);
+      m_sourceCount.store(index + 1, std::memory_order_release);
+      t_source = source;
+    }
+  }
+  return t_source == NO_SOURCE ? nullptr : static_cast<Source*>(t_source);
+}
+
+void Telemetry::WriterLoop() {
+  TraceRecorder::Instance().SetThreadName("telemetry");
+  std::unique_lock<std::mutex> lock(m_wakeMutex);
+  while (!m_closing) {
+    m_wakeUp.wait_for(lock, std::chrono::milliseconds(FLUSH_MS), [this] { return m_closing; });
+    lock.unlock();
+    Flush();
+    lock.lock();
+  }
+}
+
+void Telemetry::Flush() {
+  int count = m_sourceCount.load(std::memory_order_acquire);
+  for (int i = 0; i < count; i++) {
+    Source* source = m_sources[i].load(std::memory_order_acquire);
+    m_written += static_cast<long long>(source->ring.Drain([this](const Record* records, size_t n) {
+      m_file.write(reinterpret_cast<const char*>(records), static_cast<std::streamsize>(n * sizeof(Record)));
+    }));
+  }
+  // A crashed session keeps everything up to the last flush.
+  m_file.flush();
+}
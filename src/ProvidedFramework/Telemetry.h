@@ -0,0 +1,135 @@
+#ifndef TELEMETRY_H__
+#define TELEMETRY_H__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MemoryTracker.h"
+#include "SpscRing.h"
+
+// Gameplay telemetry for a session: object counts per tick, damage, kills,
+// pickups, level and frame times and frame governor steps, to correlate
+// load with difficulty.
+//
+// Emit() stamps a fixed-size Record and pushes it into a ring owned by the
+// calling thread; it never locks, never touches the file and only allocates
+// for the first record of a thread. A writer thread wakes every FLUSH_MS,
+// drains all rings and appends their records to the file. If the writer
+// falls so far behind that a ring fills up, further records are dropped and
+// counted instead of waited for.
+//
+// The file is a FileHeader followed by Records, in host byte order. Records
+// of one source are in the order they were emitted; sources interleave.
+// DawnbreakerTelemetry converts a file to CSV.
+class Telemetry {
+public:
+  enum class Kind : uint8_t {
+    TICK,         // value0: objects, value1: particles
+    OBJECTS,      // subject: object type; value0: how many exist
+    DAMAGE,       // subject: type hit; value0: damage; value1: type dealing it
+    KILL,         // subject: type destroyed; value0: score awarded
+    PICKUP,       // subject: widget type
+    LEVEL_START,  // subject: level; value0: lives
+    LEVEL_END,    // subject: level; value0: ticks played; value1: LevelStatus
+    FRAME,        // value0: us drawing; value1: us since the previous frame
+    GOVERNOR,     // subject: FrameGovernor level; value0: average us a tick; value1: budget
+    COUNT
+  };
+
+  struct Record {
+    uint64_t ns;       // since Enable()
+    uint32_t tick;     // world tick, for FRAME the tick shown
+    uint8_t kind;
+    uint8_t source;    // recording thread, numbered in order of first record
+    uint16_t subject;
+    int32_t value0;
+    int32_t value1;
+  };
+
+  struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+  };
+
+  static const uint32_t VERSION = 1;
+  static constexpr int FLUSH_MS = 50;
+  // Per source, 1.5 MB: a headless autopilot run emits a few hundred
+  // thousand records a second, the game at 60 ticks a second a few hundred.
+  static const size_t RING_RECORDS = 65536;
+  static const int MAX_SOURCES = 32;
+
+  // Mayers' singleton pattern
+  Telemetry(const Telemetry& other) = delete;
+  Telemetry& operator=(const Telemetry& other) = delete;
+  static Telemetry& Instance() { static Telemetry instance; return instance; }
+  ~Telemetry();
+
+  // Creates path and starts the writer thread.
+  bool Enable(const std::string& path);
+  bool IsEnabled() const { return m_enabled.load(std::memory_order_acquire); }
+
+  void Emit(Kind kind, int tick, int subject = 0, int value0 = 0, int value1 = 0) {
+    if (IsEnabled()) {
+      Push(kind, tick, subject, value0, value1);
+    }
+  }
+
+  // Writes what is still queued, stops the writer and closes the file.
+  void Close();
+  // Records written and dropped, and the file size.
+  void Print(std::ostream& out) const;
+
+  static const char* KindName(Kind kind);
+  // Every record of a file; false if in does not hold telemetry this
+  // version can read.
+  static bool Read(std::istream& in, std::vector<Record>& records);
+
+private:
+  using Clock = std::chrono::steady_clock;
+  using Ring = SpscRing<Record, TrackingAllocator<Record, TelemetryMemTag>>;
+
+  struct Source {
+    explicit Source(int index) : ring(RING_RECORDS), index(index), dropped(0) {}
+    Ring ring;
+    int index;
+    std::atomic<long long> dropped;
+  };
+
+  Telemetry();
+  void Push(Kind kind, int tick, int subject, int value0, int value1);
+  Source* LocalSource();
+  void WriterLoop();
+  // Writer thread only.
+  void Flush();
+
+  std::atomic<bool> m_enabled;
+  Clock::time_point m_start;
+
+  // Filled in order under m_sourcesMutex, read by the writer without it.
+  std::array<std::atomic<Source*>, MAX_SOURCES> m_sources;
+  std::atomic<int> m_sourceCount;
+  std::mutex m_sourcesMutex;
+  std::atomic<long long> m_unsourced;
+
+  std::ofstream m_file;
+  std::string m_path;
+  long long m_written;
+  std::mutex m_wakeMutex;
+  std::condition_variable m_wakeUp;
+  bool m_closing;
+  std::thread m_writer;
+};
+
+#endif // !TELEMETRY_H__
@@ -0,0 +1,257 @@
+#include "TextRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "utils.h"
+#include "TraceRecorder.h"
+
+static int NextPowerOfTwo(int value) {
+  int power = 1;
+  while (power < value) {
+    power *= 2;
+  }
+  return power;
+}
+
+TextRenderer::TextRenderer() : m_atlases(), m_ready(true), m_cache(), m_draws(0), m_layouts(0) {
+  TraceRecorder::Scope trace("text", "TextRenderer::Rasterise");
+  for (int font = 0; font < static_cast<int>(Font::COUNT); font++) {
+    if (!Rasterise(static_cast<Font>(font), m_atlases[font])) {
+      m_ready = false;
+      Release();
+      break;
+    }
+  }
+  m_cache.reserve(CACHE_SIZE);
+}
+
+TextRenderer::~TextRenderer() {
+  Release();
+}
+
+void TextRenderer::Release() {
+  for (Atlas& atlas : m_atlases) {
+    if (atlas.texture != 0) {
+      glDeleteTextures(1, &atlas.texture);
+      MemoryTracker::Instance().Deallocate(TextMemTag::Id(),
+        static_cast<size_t>(atlas.metrics.textureWidth) * atlas.metrics.textureHeight);
+      atlas.texture = 0;
+    }
+  }
+}
+
+bool TextRenderer::IsReady() const {
+  return m_ready;
+}
+
+void* TextRenderer::GlutFont(Font font) {
+  switch (font) {
+  case Font::HELVETICA_10:
+    return GLUT_BITMAP_HELVETICA_10;
+  case Font::HELVETICA_12:
+    return GLUT_BITMAP_HELVETICA_12;
+  case Font::HELVETICA_18:
+  default:
+    return GLUT_BITMAP_HELVETICA_18;
+  }
+}
+
+bool TextRenderer::Rasterise(Font font, Atlas& atlas) {
+  void* glutFont = GlutFont(font);
+  Metrics& metrics = atlas.metrics;
+  int maxAdvance = 0;
+  for (int glyph = 0; glyph < GLYPH_COUNT; glyph++) {
+    int advance = glutBitmapWidth(glutFont, FIRST_GLYPH + glyph);
+    metrics.advance[glyph] = static_cast<unsigned char>(advance);
+    maxAdvance = std::max(maxAdvance, advance);
+  }
+  int fontHeight = glutBitmapHeight(glutFont);
+  // Glyphs may reach a little left of the pen and below the baseline; the
+  // padding keeps them inside their cell.
+  metrics.cellWidth = maxAdvance + 2 * PAD;
+  metrics.cellHeight = fontHeight + 2 * PAD;
+  metrics.descent = fontHeight / 4 + PAD;
+  int rows = (GLYPH_COUNT + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS;
+  int width = metrics.cellWidth * ATLAS_COLUMNS;
+  int height = metrics.cellHeight * rows;
+  if (width > WINDOW_WIDTH || height > WINDOW_HEIGHT) {
+    return false;
+  }
+  // Power-of-two sizes for GL 1.x drivers.
+  metrics.textureWidth = NextPowerOfTwo(width);
+  metrics.textureHeight = NextPowerOfTwo(height);
+
+  // Draw the glyphs in the top left corner of the back buffer, the part of
+  // the window most likely to be on screen, one per cell.
+  int originX = 0;
+  int originY = WINDOW_HEIGHT - height;
+  glMatrixMode(GL_PROJECTION);
+  glPushMatrix();
+  glLoadIdentity();
+  glOrtho(0, WINDOW_WIDTH, 0, WINDOW_HEIGHT, -1, 1);
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  glLoadIdentity();
+  glPushAttrib(GL_COLOR_BUFFER_BIT | GL_ENABLE_BIT | GL_CURRENT_BIT | GL_TEXTURE_BIT);
+  glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_TEXTURE_2D);
+  glDisable(GL_BLEND);
+  glClearColor(0, 0, 0, 0);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glColor3f(1.0f, 1.0f, 1.0f);
+  for (int glyph = 0; glyph < GLYPH_COUNT; glyph++) {
+    int cellX = originX + (glyph % ATLAS_COLUMNS) * metrics.cellWidth;
+    int cellY = originY + (glyph / ATLAS_COLUMNS) * metrics.cellHeight;
+    glRasterPos2i(cellX + PAD, cellY + metrics.descent);
+    glutBitmapCharacter(glutFont, FIRST_GLYPH + glyph);
+  }
+
+  std::vector<unsigned char, TrackingAllocator<unsigned char, TextMemTag>> pixels(
+    static_cast<size_t>(metrics.textureWidth) * metrics.textureHeight, 0);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glPixelStorei(GL_PACK_ROW_LENGTH, metrics.textureWidth);
+  glReadPixels(originX, originY, width, height, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+  glClear(GL_COLOR_BUFFER_BIT);
+
+  bool drawn = std::any_of(pixels.begin(), pixels.end(), [](unsigned char value) { return value != 0; });
+  if (drawn) {
+    glGenTextures(1, &atlas.texture);
+    glBindTexture(GL_TEXTURE_2D, atlas.texture);
+    // One texel per pixel, so no filtering.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, metrics.textureWidth, metrics.textureHeight, 0,
+                 GL_ALPHA, GL_UNSIGNED_BYTE, pixels.data());
+    MemoryTracker::Instance().Allocate(TextMemTag::Id(), pixels.size());
+  }
+
+  glPopClientAttrib();
+  glPopAttrib();
+  glMatrixMode(GL_MODELVIEW);
+  glPopMatrix();
+  glMatrixMode(GL_PROJECTION);
+  glPopMatrix();
+  glMatrixMode(GL_MODELVIEW);
+  return drawn;
+}
+
+int TextRenderer::TextWidth(const Metrics& metrics, const char* text) {
+  int width = 0;
+  for (const char* c = text; *c != '\0'; c++) {
+    int glyph = static_cast<unsigned char>(*c) - FIRST_GLYPH;
+    if (glyph >= 0 && glyph < GLYPH_COUNT) {
+      width += metrics.advance[glyph];
+    }
+  }
+  return width;
+}
+
+void TextRenderer::Layout(const Metrics& metrics, double x, double y, const char* text, bool centering,
+                          Vertices& vertices) {
+  if (centering) {
+    x = -(static_cast<double>(TextWidth(metrics, text)) / WINDOW_WIDTH);
+  }
+  // glBitmap starts at the pixel holding the raster position.
+  int penX = static_cast<int>(std::floor((x + 1.0) * WINDOW_WIDTH / 2.0));
+  int baseY = static_cast<int>(std::floor((y + 1.0) * WINDOW_HEIGHT / 2.0));
+  float cellS = static_cast<float>(metrics.cellWidth) / metrics.textureWidth;
+  float cellT = static_cast<float>(metrics.cellHeight) / metrics.textureHeight;
+  float bottom = 2.0f * (baseY - metrics.descent) / WINDOW_HEIGHT - 1.0f;
+  float top = 2.0f * (baseY - metrics.descent + metrics.cellHeight) / WINDOW_HEIGHT - 1.0f;
+  for (const char* c = text; *c != '\0'; c++) {
+    int glyph = static_cast<unsigned char>(*c) - FIRST_GLYPH;
+    if (glyph < 0 || glyph >= GLYPH_COUNT) {
+      continue;
+    }
+    if (*c != ' ') {
+      float left = 2.0f * (penX - PAD) / WINDOW_WIDTH - 1.0f;
+      float right = 2.0f * (penX - PAD + metrics.cellWidth) / WINDOW_WIDTH - 1.0f;
+      float s = (glyph % ATLAS_COLUMNS) * cellS;
+      float t = (glyph / ATLAS_COLUMNS) * cellT;
+      vertices.push_back({ left, bottom, s, t });
+      vertices.push_back({ right, bottom, s + cellS, t });
+      vertices.push_back({ right, top, s + cellS, t + cellT });
+      vertices.push_back({ left, top, s, t + cellT });
+    }
+    penX += metrics.advance[glyph];
+  }
+}
+
+TextRenderer::CachedText& TextRenderer::Lookup(Font font, double x, double y, const char* text, bool centering) {
+  CachedText* slot = nullptr;
+  for (CachedText& cached : m_cache) {
+    if (cached.font == font && cached.x == x && cached.y == y && cached.centering == centering) {
+      slot = &cached;
+      break;
+    }
+  }
+  bool stale = slot == nullptr || slot->text != text;
+  if (slot == nullptr) {
+    if (m_cache.size() < CACHE_SIZE) {
+      m_cache.push_back(CachedText{ font, x, y, centering, std::string(), Vertices(), 0 });
+      slot = &m_cache.back();
+    }
+    else {
+      slot = &*std::min_element(m_cache.begin(), m_cache.end(), [](const CachedText& a, const CachedText& b) {
+        return a.lastUsed < b.lastUsed;
+      });
+      slot->font = font;
+      slot->x = x;
+      slot->y = y;
+      slot->centering = centering;
+    }
+  }
+  if (stale) {
+    slot->text = text;
+    slot->vertices.clear();
+    Layout(m_atlases[static_cast<int>(font)].metrics, x, y, text, centering, slot->vertices);
+    m_layouts++;
+  }
+  slot->lastUsed = m_draws;
+  return *slot;
+}
+
+void TextRenderer::Draw(Font font, double x, double y, const char* text, bool centering) {
+  m_draws++;
+  const CachedText& cached = Lookup(font, x, y, text, centering);
+  if (cached.vertices.empty()) {
+    return;
+  }
+  glPushMatrix();
+  glLoadIdentity();
+  glPushAttrib(GL_COLOR_BUFFER_BIT | GL_ENABLE_BIT | GL_TEXTURE_BIT);
+  glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+  glEnable(GL_TEXTURE_2D);
+  glDisable(GL_DEPTH_TEST);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glBindTexture(GL_TEXTURE_2D, m_atlases[static_cast<int>(font)].texture);
+  // Colour from glColor, coverage from the atlas.
+  glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &cached.vertices[0].x);
+  glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &cached.vertices[0].s);
+  glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(cached.vertices.size()));
+
+  glPopClientAttrib();
+  glPopAttrib();
+  glPopMatrix();
+}
+
+long long TextRenderer::GetLayoutCount() const {
+  return m_layouts;
+}
+
+long long TextRenderer::GetDrawCount() const {
+  return m_draws;
+}
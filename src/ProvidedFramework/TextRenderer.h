@@ -0,0 +1,116 @@
+#ifndef TEXTRENDERER_H__
+#define TEXTRENDERER_H__
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <GL/glut.h>
+#include <GL/freeglut.h>
+
+#include "MemoryTracker.h"
+
+// Draws text as textured quads from one glyph atlas per font.
+//
+// glutBitmapString() issues a glBitmap per character, which software GL
+// renderers handle very slowly. Instead each GLUT bitmap font is rasterised
+// once, when the renderer is created, by drawing its printable ASCII glyphs
+// into the back buffer and reading them back into an alpha texture. A string
+// then costs one texture bind and one glDrawArrays. Its quads are cached per
+// draw position and only laid out again when the text there changes, which
+// for the status bar is a few times a second at most.
+//
+// Needs the GL context of a window that is on screen; GameManager creates
+// it at the start of the first frame, and it is destroyed, deleting the
+// atlases, while that context is still current. Text takes the current
+// glColor, like glutBitmapString.
+class TextRenderer {
+public:
+  enum class Font { HELVETICA_10, HELVETICA_12, HELVETICA_18, COUNT };
+
+  static const int FIRST_GLYPH = 32;
+  static const int GLYPH_COUNT = 95;
+
+  // Where a font's glyphs are in its atlas, in pixels. Glyph g sits in the
+  // cell at column g % ATLAS_COLUMNS, row g / ATLAS_COLUMNS, and is drawn
+  // PAD pixels from the left edge of the cell and descent pixels above its
+  // bottom.
+  struct Metrics {
+    int textureWidth = 0;
+    int textureHeight = 0;
+    int cellWidth = 0;
+    int cellHeight = 0;
+    int descent = 0;
+    std::array<unsigned char, GLYPH_COUNT> advance = { };
+  };
+
+  struct Vertex {
+    float x;
+    float y;
+    float s;
+    float t;
+  };
+
+  using Vertices = std::vector<Vertex, TrackingAllocator<Vertex, TextMemTag>>;
+
+  static const int ATLAS_COLUMNS = 16;
+  static const int PAD = 2;
+
+  TextRenderer();
+  ~TextRenderer();
+  TextRenderer(const TextRenderer& other) = delete;
+  TextRenderer& operator=(const TextRenderer& other) = delete;
+
+  // False when the glyphs could not be read back, e.g. while the window is
+  // not mapped yet; callers then fall back to glutBitmapString(). A renderer
+  // that is not ready holds no atlases.
+  bool IsReady() const;
+
+  // Same placement as glRasterPos + glutBitmapString: the baseline of the
+  // first glyph starts at (x, y) in normalized device coordinates, or the
+  // string is centred horizontally when centering.
+  void Draw(Font font, double x, double y, const char* text, bool centering);
+
+  // The GLUT font the atlas of font is made from.
+  static void* GlutFont(Font font);
+
+  // Quads for text in window pixels converted to normalized device
+  // coordinates; appends to vertices. No GL involved.
+  static void Layout(const Metrics& metrics, double x, double y, const char* text, bool centering,
+                     Vertices& vertices);
+  static int TextWidth(const Metrics& metrics, const char* text);
+
+  long long GetLayoutCount() const;
+  long long GetDrawCount() const;
+
+private:
+  struct Atlas {
+    GLuint texture = 0;
+    Metrics metrics;
+  };
+
+  struct CachedText {
+    Font font;
+    double x;
+    double y;
+    bool centering;
+    std::string text;
+    Vertices vertices;
+    long long lastUsed;
+  };
+
+  static const size_t CACHE_SIZE = 16;
+
+  bool Rasterise(Font font, Atlas& atlas);
+  // Deletes the atlas textures built so far.
+  void Release();
+  CachedText& Lookup(Font font, double x, double y, const char* text, bool centering);
+
+  std::array<Atlas, static_cast<size_t>(Font::COUNT)> m_atlases;
+  bool m_ready;
+  std::vector<CachedText> m_cache;
+  long long m_draws;
+  long long m_layouts;
+};
+
+#endif // !TEXTRENDERER_H__
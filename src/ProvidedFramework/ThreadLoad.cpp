@@ -0,0 +1,43 @@
+#include "ThreadLoad.h"
+
+#include <iomanip>
+
+ThreadLoad::ThreadLoad()
+  : m_first(), m_begin(), m_last(), m_busy(Clock::duration::zero()), m_worst(Clock::duration::zero()), m_count(0) {}
+
+void ThreadLoad::Begin() {
+  m_begin = Clock::now();
+  if (m_count == 0) {
+    m_first = m_begin;
+  }
+}
+
+void ThreadLoad::End() {
+  m_last = Clock::now();
+  Clock::duration spent = m_last - m_begin;
+  m_busy += spent;
+  if (spent > m_worst) {
+    m_worst = spent;
+  }
+  m_count++;
+}
+
+long long ThreadLoad::GetCount() const {
+  return m_count;
+}
+
+void ThreadLoad::Print(std::ostream& out, const char* name, const char* unit) const {
+  if (m_count == 0) {
+    return;
+  }
+  using Ms = std::chrono::duration<double, std::milli>;
+  double wall = Ms(m_last - m_first).count();
+  double busy = Ms(m_busy).count();
+  out << std::left << std::setw(12) << name << std::right << std::setw(8) << m_count << " " << unit
+      << std::fixed << std::setprecision(1)
+      << "  busy " << std::setw(5) << (wall > 0 ? 100.0 * busy / wall : 100.0) << "%"
+      << std::setprecision(3)
+      << "  mean " << busy / m_count << " ms"
+      << "  worst " << Ms(m_worst).count() << " ms\n";
+  out.unsetf(std::ios::floatfield);
+}
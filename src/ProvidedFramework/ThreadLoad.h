@@ -0,0 +1,33 @@
+#ifndef THREADLOAD_H__
+#define THREADLOAD_H__
+
+#include <chrono>
+#include <ostream>
+
+// How busy one thread is: the share of wall-clock time spent between
+// Begin() and End(), counted from the first Begin(). Only the measured thread
+// may call Begin()/End(); Print() once that thread has stopped or from the
+// thread itself.
+class ThreadLoad {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  ThreadLoad();
+
+  void Begin();
+  void End();
+
+  long long GetCount() const;
+  // One line: name, count, busy share and mean time per unit of work.
+  void Print(std::ostream& out, const char* name, const char* unit) const;
+
+private:
+  Clock::time_point m_first;
+  Clock::time_point m_begin;
+  Clock::time_point m_last;
+  Clock::duration m_busy;
+  Clock::duration m_worst;
+  long long m_count;
+};
+
+#endif // !THREADLOAD_H__
@@ -0,0 +1,155 @@
+#include "TraceRecorder.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "MemoryTracker.h"
+
+// The calling thread's buffer, owned by TraceRecorder::m_buffers.
+static thread_local void* t_buffer = nullptr;
+
+TraceRecorder::ThreadBuffer::ThreadBuffer(int tid)
+  : tid(tid), name("thread " + std::to_string(tid)), chunks(), count(0), dropped(0) {
+  for (auto& chunk : chunks) {
+    chunk.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+TraceRecorder::ThreadBuffer::~ThreadBuffer() {
+  for (auto& chunk : chunks) {
+    Event* events = chunk.load(std::memory_order_relaxed);
+    if (events != nullptr) {
+      MemoryTracker::Instance().Deallocate(TraceMemTag::Id(), sizeof(Event) * EVENTS_PER_CHUNK);
+      delete[] events;
+    }
+  }
+}
+
+TraceRecorder::TraceRecorder()
+  : m_enabled(false), m_path(), m_start(Clock::now()), m_buffersMutex(), m_buffers() {}
+
+void TraceRecorder::Enable(const std::string& path) {
+  m_path = path;
+  m_start = Clock::now();
+  m_enabled.store(true, std::memory_order_relaxed);
+}
+
+void TraceRecorder::Begin(const char* category, const char* name) {
+  if (IsEnabled()) {
+    Record('B', category, name, nullptr);
+  }
+}
+
+void TraceRecorder::End(const char* category, const char* name) {
+  if (IsEnabled()) {
+    Record('E', category, name, nullptr);
+  }
+}
+
+void TraceRecorder::Instant(const char* category, const char* name, const char* detail) {
+  if (IsEnabled()) {
+    Record('i', category, name, detail);
+  }
+}
+
+void TraceRecorder::SetThreadName(const std::string& name) {
+  if (!IsEnabled()) {
+    return;
+  }
+  ThreadBuffer& buffer = LocalBuffer();
+  std::lock_guard<std::mutex> lock(m_buffersMutex);
+  buffer.name = name;
+}
+
+TraceRecorder::ThreadBuffer& TraceRecorder::LocalBuffer() {
+  if (t_buffer == nullptr) {
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    m_buffers.push_back(std::make_unique<ThreadBuffer>(static_cast<int>(m_buffers.size()) + 1));
+    t_buffer = m_buffers.back().get();
+  }
+  return *static_cast<ThreadBuffer*>(t_buffer);
+}
+
+void TraceRecorder::Record(char phase, const char* category, const char* name, const char* detail) {
+  long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count();
+  ThreadBuffer& buffer = LocalBuffer();
+
+  size_t index = buffer.count.load(std::memory_order_relaxed);
+  size_t chunkIndex = index / EVENTS_PER_CHUNK;
+  if (chunkIndex >= MAX_CHUNKS) {
+    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  Event* chunk = buffer.chunks[chunkIndex].load(std::memory_order_relaxed);
+  if (chunk == nullptr) {
+    chunk = new Event[EVENTS_PER_CHUNK];
+    MemoryTracker::Instance().Allocate(TraceMemTag::Id(), sizeof(Event) * EVENTS_PER_CHUNK);
+    buffer.chunks[chunkIndex].store(chunk, std::memory_order_release);
+  }
+
+  Event& event = chunk[index % EVENTS_PER_CHUNK];
+  event.category = category;
+  event.name = name;
+  event.detail = detail;
+  event.ns = ns;
+  event.phase = phase;
+  // Publishes the event to Write().
+  buffer.count.store(index + 1, std::memory_order_release);
+}
+
+bool TraceRecorder::Write() const {
+  std::ofstream out(m_path);
+  if (!out) {
+    std::cerr << "Cannot write trace '" << m_path << "'" << std::endl;
+    return false;
+  }
+  Write(out);
+  return true;
+}
+
+void TraceRecorder::Write(std::ostream& out) const {
+  std::lock_guard<std::mutex> lock(m_buffersMutex);
+
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  bool first = true;
+  size_t dropped = 0;
+  for (const auto& buffer : m_buffers) {
+    out << (first ? "" : ",\n")
+        << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->tid
+        << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+    first = false;
+
+    size_t count = buffer->count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++) {
+      const Event* chunk = buffer->chunks[i / EVENTS_PER_CHUNK].load(std::memory_order_acquire);
+      const Event& event = chunk[i % EVENTS_PER_CHUNK];
+      out << ",\n{\"ph\":\"" << event.phase << "\",\"cat\":\"" << event.category
+          << "\",\"name\":\"" << event.name << "\",\"pid\":1,\"tid\":" << buffer->tid
+          << ",\"ts\":" << event.ns / 1000 << "." << std::setw(3) << std::setfill('0')
+          << event.ns % 1000 << std::setfill(' ');
+      if (event.phase == 'i') {
+        out << ",\"s\":\"t\"";
+      }
+      if (event.detail != nullptr) {
+        out << ",\"args\":{\"detail\":\"" << event.detail << "\"}";
+      }
+      out << "}";
+    }
+    dropped += buffer->dropped.load(std::memory_order_relaxed);
+  }
+  out << "\n]}\n";
+
+  if (dropped > 0) {
+    std::cerr << "Trace buffers were full, " << dropped << " events dropped" << std::endl;
+  }
+}
+
+TraceRecorder::Scope::Scope(const char* category, const char* name)
+  : m_category(category), m_name(name) {
+  TraceRecorder::Instance().Begin(category, name);
+}
+
+TraceRecorder::Scope::~Scope() {
+  TraceRecorder::Instance().End(m_category, m_name);
+}
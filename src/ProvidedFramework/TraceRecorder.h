@@ -0,0 +1,96 @@
+#ifndef TRACERECORDER_H__
+#define TRACERECORDER_H__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Records begin/end and instant events and writes them as Chrome trace JSON,
+// which chrome://tracing and ui.perfetto.dev open directly.
+//
+// Every thread appends to its own buffer without taking a lock: events go
+// into fixed-size chunks that never move and the event count is published
+// with a release store, so Write() can run while other threads keep
+// recording. A buffer that runs out of chunks drops further events.
+//
+// Categories, names and details are not copied; pass string literals or
+// other strings that outlive the recorder.
+class TraceRecorder {
+public:
+  static const int EVENTS_PER_CHUNK = 4096;
+  static const int MAX_CHUNKS = 256;  // per thread, about a million events
+
+  // Mayers' singleton pattern
+  TraceRecorder(const TraceRecorder& other) = delete;
+  TraceRecorder& operator=(const TraceRecorder& other) = delete;
+  static TraceRecorder& Instance() { static TraceRecorder instance; return instance; }
+
+  // Starts recording; Write() goes to path.
+  void Enable(const std::string& path);
+  bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  void Begin(const char* category, const char* name);
+  void End(const char* category, const char* name);
+  // detail shows up as the event's argument, e.g. the type of a spawned object.
+  void Instant(const char* category, const char* name, const char* detail = nullptr);
+
+  // Names the calling thread in the trace.
+  void SetThreadName(const std::string& name);
+
+  // Writes every event recorded so far to the path given to Enable().
+  bool Write() const;
+  void Write(std::ostream& out) const;
+
+  // Begin() on construction, End() on destruction.
+  class Scope {
+  public:
+    Scope(const char* category, const char* name);
+    ~Scope();
+    Scope(const Scope& other) = delete;
+    Scope& operator=(const Scope& other) = delete;
+  private:
+    const char* m_category;
+    const char* m_name;
+  };
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Event {
+    const char* category;
+    const char* name;
+    const char* detail;
+    long long ns;
+    char phase;
+  };
+
+  // Written by its own thread only, read by Write().
+  struct ThreadBuffer {
+    ThreadBuffer(int tid);
+    ~ThreadBuffer();
+
+    int tid;
+    std::string name;  // guarded by m_buffersMutex
+    std::array<std::atomic<Event*>, MAX_CHUNKS> chunks;
+    std::atomic<size_t> count;
+    std::atomic<size_t> dropped;
+  };
+
+  TraceRecorder();
+  ThreadBuffer& LocalBuffer();
+  void Record(char phase, const char* category, const char* name, const char* detail);
+
+  std::atomic<bool> m_enabled;
+  std::string m_path;
+  Clock::time_point m_start;
+  // Taken once per thread when it records its first event, and by Write().
+  mutable std::mutex m_buffersMutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+};
+
+#endif // !TRACERECORDER_H__
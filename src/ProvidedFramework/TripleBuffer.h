@@ -0,0 +1,60 @@
+#ifndef TRIPLEBUFFER_H__
+#define TRIPLEBUFFER_H__
+
+#include <array>
+#include <atomic>
+
+// Hands the newest value from one producer thread to one consumer thread
+// without either of them ever waiting.
+//
+// The producer fills Back() and publishes it; the consumer acquires the most
+// recently published value and reads it through Front(). The third slot sits
+// between them, so the producer can always start on a fresh slot while the
+// consumer still reads its own. Values the consumer never got to are simply
+// overwritten. Slots are reused, so a T holding containers keeps its capacity.
+template<typename T>
+class TripleBuffer {
+public:
+  TripleBuffer() : m_slots(), m_back(0), m_ready(1), m_front(2) {}
+  TripleBuffer(const TripleBuffer& other) = delete;
+  TripleBuffer& operator=(const TripleBuffer& other) = delete;
+
+  // Producer only: the slot to fill next. It holds whatever value it held
+  // last, so it has to be overwritten completely.
+  T& Back() { return m_slots[m_back]; }
+
+  // Producer only: makes Back() the newest value. Returns false when it
+  // replaced a value the consumer never acquired.
+  bool Publish() {
+    unsigned char previous = m_ready.exchange(static_cast<unsigned char>(m_back | FRESH), std::memory_order_acq_rel);
+    m_back = previous & INDEX;
+    return (previous & FRESH) == 0;
+  }
+
+  // Consumer only: moves to the newest published value. Returns false when
+  // nothing was published since the last call, Front() is then unchanged.
+  bool Acquire() {
+    if ((m_ready.load(std::memory_order_relaxed) & FRESH) == 0) {
+      return false;
+    }
+    unsigned char ready = m_ready.exchange(m_front, std::memory_order_acq_rel);
+    m_front = ready & INDEX;
+    return true;
+  }
+
+  // Consumer only.
+  const T& Front() const { return m_slots[m_front]; }
+
+private:
+  static const unsigned char INDEX = 0x3;
+  static const unsigned char FRESH = 0x4;
+
+  std::array<T, 3> m_slots;
+  unsigned char m_back;
+  // Index of the middle slot, with FRESH set while it holds a value the
+  // consumer has not acquired yet.
+  std::atomic<unsigned char> m_ready;
+  unsigned char m_front;
+};
+
+#endif // !TRIPLEBUFFER_H__
@@ -1,14 +1,39 @@
 #include "WorldBase.h"
-#include "GameManager.h"
 
-WorldBase::WorldBase() : m_level(1), m_score(0) {}
+thread_local WorldBase* WorldBase::s_current = nullptr;
+
+static RandomGenerator::result_type RandomSeed() {
+  std::random_device rd;
+  return (static_cast<RandomGenerator::result_type>(rd()) << 32) ^ rd();
+}
+
+WorldContext::WorldContext() : registry(), random(RandomSeed()), input(nullptr), statusBar() {}
+
+RandomGenerator& randGenerator() {
+  WorldBase* world = WorldBase::Current();
+  if (world != nullptr) {
+    return world->GetContext().random;
+  }
+  thread_local RandomGenerator generator(RandomSeed());
+  return generator;
+}
+
+WorldBase::WorldBase() : m_level(1), m_score(0), m_context() {}
 
 WorldBase::~WorldBase() {}
 
+bool WorldBase::IsPausable() const {
+  return true;
+}
+
 int WorldBase::GetScore() const {
   return m_score;
 }
 
+void WorldBase::SetScore(int score) {
+  m_score = score;
+}
+
 void WorldBase::IncreaseScore(int earnedScore) {
   m_score += earnedScore;
 }
@@ -22,13 +47,46 @@ void WorldBase::SetLevel(int level) {
 }
 
 bool WorldBase::GetKey(KeyCode key) const {
-  return GameManager::Instance().GetKey(key);
+  return m_context.input != nullptr && m_context.input->GetKey(key);
 }
 
 bool WorldBase::GetKeyDown(KeyCode key) const {
-  return GameManager::Instance().GetKeyDown(key);
+  return m_context.input != nullptr && m_context.input->GetKeyDown(key);
+}
+
+void WorldBase::SetInputSource(InputSource* input) {
+  m_context.input = input;
+}
+
+InputSource* WorldBase::GetInputSource() const {
+  return m_context.input;
+}
+
+void WorldBase::SetStatusBarMessage(std::string message) {
+  m_context.statusBar.assign(message.begin(), message.end());
+}
+
+const HudString& WorldBase::GetStatusBarMessage() const {
+  return m_context.statusBar;
+}
+
+WorldContext& WorldBase::GetContext() {
+  return m_context;
+}
+
+const WorldContext& WorldBase::GetContext() const {
+  return m_context;
+}
+
+
+WorldBase* WorldBase::Current() {
+  return s_current;
+}
+
+WorldBase::Scope::Scope(WorldBase& world) : m_previous(s_current) {
+  s_current = &world;
 }
 
-void WorldBase::SetStatusBarMessage(std::string message) const {
-  GameManager::Instance().SetStatusBarMessage(message);
+WorldBase::Scope::~Scope() {
+  s_current = m_previous;
 }
@@ -8,6 +8,8 @@
 #include <GL/freeglut.h>
 
 #include "utils.h"
+#include "InputSource.h"
+#include "WorldContext.h"
 
 
 class WorldBase : public std::enable_shared_from_this<WorldBase> {
@@ -23,19 +25,53 @@ public:
 
   virtual bool IsGameOver() const = 0;
 
+  // Whether the world may stop being stepped while the window is hidden.
+  virtual bool IsPausable() const;
+
   int GetLevel() const;
   void SetLevel(int level);
 
   int GetScore() const;
+  void SetScore(int score);
   void IncreaseScore(int earnedScore);
 
   bool GetKey(KeyCode key) const;
   bool GetKeyDown(KeyCode key) const;
-  void SetStatusBarMessage(std::string message) const;
+  // Where GetKey/GetKeyDown read from; without a source no key is ever
+  // pressed. GameManager plugs in the keyboard unless a source is already set.
+  // The world does not own the source.
+  void SetInputSource(InputSource* input);
+  InputSource* GetInputSource() const;
+  const HudString& GetStatusBarMessage() const;
+
+  // Registry, random generator, input and status bar of this world.
+  WorldContext& GetContext();
+  const WorldContext& GetContext() const;
+  void SetStatusBarMessage(std::string message);
+
+  // The world being initialized, updated or cleaned up on this thread, or
+  // null. Objects are created while their world is current and join its
+  // registry; objects that cannot find their world some other way must also
+  // be destroyed while it is current.
+  static WorldBase* Current();
+
+  // Makes a world current for the lifetime of the scope.
+  class Scope {
+  public:
+    explicit Scope(WorldBase& world);
+    ~Scope();
+    Scope(const Scope& other) = delete;
+    Scope& operator=(const Scope& other) = delete;
+  private:
+    WorldBase* m_previous;
+  };
 
 private:
+  static thread_local WorldBase* s_current;
+
   int m_level;
   int m_score;
+  WorldContext m_context;
 };
 
 
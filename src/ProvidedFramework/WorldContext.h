@@ -0,0 +1,46 @@
+#ifndef WORLDCONTEXT_H__
+#define WORLDCONTEXT_H__
+
+#include <string>
+#include <vector>
+
+#include "utils.h"
+#include "MemoryTracker.h"
+#include "InputSource.h"
+
+class ObjectBase;
+class ParticleBatch;
+
+using HudString = std::basic_string<char, std::char_traits<char>, TrackingAllocator<char, HudMemTag>>;
+
+// Per layer, the objects and particle batches GameManager draws.
+class RenderRegistry {
+public:
+  using Objects = std::vector<ObjectBase*, TrackingAllocator<ObjectBase*, RenderRegistryMemTag>>;
+  using Batches = std::vector<ParticleBatch*, TrackingAllocator<ParticleBatch*, RenderRegistryMemTag>>;
+
+  Objects& GetObjects(int layer) { return m_objects[layer < MAX_LAYERS ? layer : 0]; }
+  const Objects& GetObjects(int layer) const { return m_objects[layer < MAX_LAYERS ? layer : 0]; }
+  Batches& GetBatches(int layer) { return m_batches[layer < MAX_LAYERS ? layer : 0]; }
+  const Batches& GetBatches(int layer) const { return m_batches[layer < MAX_LAYERS ? layer : 0]; }
+
+private:
+  Objects m_objects[MAX_LAYERS];
+  Batches m_batches[MAX_LAYERS];
+};
+
+// State that used to be process-wide (the object registry, the random
+// generator, the keyboard and the status bar). Every WorldBase owns one, so
+// worlds stepped on different threads share nothing mutable.
+struct WorldContext {
+  WorldContext();
+  WorldContext(const WorldContext& other) = delete;
+  WorldContext& operator=(const WorldContext& other) = delete;
+
+  RenderRegistry registry;
+  RandomGenerator random;
+  InputSource* input;
+  HudString statusBar;
+};
+
+#endif // !WORLDCONTEXT_H__
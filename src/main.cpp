@@ -1,13 +1,181 @@
+#include <algorithm>
 #include <memory>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 
 #include "GameManager.h"
 #include "GameWorld.h"
+#include "Autopilot.h"
+#include "VersusWorld.h"
 
 #include <GL/freeglut.h>
 
 
 int main(int argc, char** argv) {
-  std::shared_ptr<WorldBase> world = std::make_shared<GameWorld>();
+  // Versus mode replaces the world, so it is picked before anything else.
+  std::shared_ptr<VersusWorld> versus;
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], "--versus") == 0) {
+      bool host = strcmp(argv[i + 1], "host") == 0;
+      if (!host && strcmp(argv[i + 1], "join") != 0) {
+        std::cerr << "--versus takes 'host' or 'join'" << std::endl;
+        return EXIT_FAILURE;
+      }
+      versus = std::make_shared<VersusWorld>(host ? VersusWorld::Role::HOST : VersusWorld::Role::GUEST);
+      versus->SetLocalInput(&GameManager::Instance().GetKeyboard());
+    }
+  }
+  if (versus != nullptr) {
+    // Each peer simulates both worlds; these would only change the local one
+    // and so desync the match.
+    const char* const localOnly[] = { "--stress", "--ship-cap", "--fire-interval", "--auto-fire",
+                                      "--stars-per-tick", "--enemy-fire-interval", "--checkpoint", "--restore" };
+    for (int i = 1; i < argc; i++) {
+      for (const char* flag : localOnly) {
+        if (strcmp(argv[i], flag) == 0) {
+          std::cerr << flag << " cannot be used with --versus" << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+  std::shared_ptr<GameWorld> world = versus;
+  if (world == nullptr) {
+    world = std::make_shared<GameWorld>();
+  }
+
+  std::unique_ptr<Autopilot> autopilot;
+  bool autopilotQuits = false;
+  int netDelay = 0;
+  int netJitter = 0;
+  int netLoss = 0;
+  StressConfig stress;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--latency-log") == 0 && i + 1 < argc) {
+      GameManager::Instance().EnableLatencyLog(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--memory-log") == 0 && i + 1 < argc) {
+      GameManager::Instance().EnableMemoryLog(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      TraceRecorder::Instance().Enable(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+      if (!Telemetry::Instance().Enable(argv[++i])) {
+        return EXIT_FAILURE;
+      }
+    }
+    else if (strcmp(argv[i], "--perf-counters") == 0) {
+      GameManager::Instance().EnablePerfCounters();
+    }
+    else if (strcmp(argv[i], "--single-thread") == 0) {
+      GameManager::Instance().SetSingleThreaded(true);
+    }
+    else if (strcmp(argv[i], "--glut-text") == 0) {
+      GameManager::Instance().SetGlutText(true);
+    }
+    else if (strcmp(argv[i], "--no-idle-throttle") == 0) {
+      GameManager::Instance().SetIdleThrottling(false);
+    }
+    else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+      if (!GameManager::Instance().EnableCapture(argv[++i])) {
+        return EXIT_FAILURE;
+      }
+    }
+    else if (strcmp(argv[i], "--opaque-first") == 0) {
+      GameManager::Instance().SetOpaqueFirst(true);
+    }
+    else if (strcmp(argv[i], "--overdraw") == 0) {
+      GameManager::Instance().EnableOverdrawView();
+    }
+    else if (strcmp(argv[i], "--fill-bench") == 0 && i + 1 < argc) {
+      GameManager::Instance().EnableFillBench(std::max(1, atoi(argv[++i])));
+    }
+    else if (strcmp(argv[i], "--memory-overlay") == 0) {
+      GameManager::Instance().EnableMemoryOverlay();
+    }
+    else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+      world->SetCheckpointFile(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc) {
+      if (!world->LoadCheckpointFile(argv[i + 1])) {
+        std::cerr << "Cannot read checkpoint '" << argv[i + 1] << "'" << std::endl;
+      }
+      i++;
+    }
+    else if (strcmp(argv[i], "--autopilot") == 0) {
+      autopilot = std::make_unique<Autopilot>(*world);
+      if (versus != nullptr) {
+        versus->SetLocalInput(autopilot.get());
+      }
+      else {
+        world->SetInputSource(autopilot.get());
+      }
+    }
+    else if (strcmp(argv[i], "--autopilot-quit") == 0) {
+      autopilotQuits = true;
+    }
+    else if (strcmp(argv[i], "--versus") == 0 && i + 1 < argc) {
+      i++;
+    }
+    else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc && versus != nullptr) {
+      versus->SetPort(static_cast<unsigned short>(atoi(argv[++i])));
+    }
+    else if (strcmp(argv[i], "--versus-levels") == 0 && i + 1 < argc && versus != nullptr) {
+      versus->SetTargetLevel(atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--net-delay") == 0 && i + 1 < argc) {
+      netDelay = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--net-jitter") == 0 && i + 1 < argc) {
+      netJitter = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--net-loss") == 0 && i + 1 < argc) {
+      netLoss = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--stress") == 0) {
+      stress.enabled = true;
+    }
+    else if (strcmp(argv[i], "--ship-cap") == 0 && i + 1 < argc) {
+      stress.enabled = true;
+      stress.shipCap = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--fire-interval") == 0 && i + 1 < argc) {
+      stress.enabled = true;
+      stress.fireInterval = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--auto-fire") == 0) {
+      stress.enabled = true;
+      stress.autoFire = true;
+    }
+    else if (strcmp(argv[i], "--stars-per-tick") == 0 && i + 1 < argc) {
+      stress.enabled = true;
+      stress.starsPerTick = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--enemy-fire-interval") == 0 && i + 1 < argc) {
+      stress.enabled = true;
+      stress.enemyFireInterval = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc) {
+      if (versus != nullptr) {
+        std::cerr << "--frame-budget is ignored in versus mode" << std::endl;
+        i++;
+      }
+      else {
+        world->SetFrameBudget(atof(argv[++i]));
+      }
+    }
+  }
+  if (stress.enabled) {
+    world->SetStressConfig(stress);
+  }
+  if (autopilot != nullptr) {
+    autopilot->SetQuitAtGameOver(autopilotQuits);
+  }
+  if (versus != nullptr) {
+    versus->SetImpairment(netDelay, netJitter, netLoss);
+  }
 
   GameManager::Instance().Play(argc, argv, world);
 }
\ No newline at end of file
@@ -45,14 +45,41 @@ const int IMGID_HP_RESTORE_GOODIE = 11;
 
 const int MS_PER_FRAME = 16;
 
+// SplitMix64 generator. Its whole state is one 64-bit word, so it can be
+// saved and restored cheaply (see GameWorld snapshots).
+class RandomGenerator {
+public:
+  using result_type = unsigned long long;
+
+  explicit RandomGenerator(result_type seed) : m_state(seed) {}
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return ~0ULL; }
+
+  result_type operator()() {
+    result_type z = (m_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  result_type GetState() const { return m_state; }
+  void SetState(result_type state) { m_state = state; }
+
+private:
+  result_type m_state;
+};
+
+// The generator of the world current on this thread (see WorldBase::Scope),
+// or a per-thread one outside any world.
+RandomGenerator& randGenerator();
+
 // Returns a random integer within [min, max] (inclusive). 
 inline int randInt(int min, int max) {
   if (max < min)
     std::swap(max, min);
-  static std::random_device rd;
-  static std::mt19937 generator(rd());
   std::uniform_int_distribution<> distro(min, max);
-  return distro(generator);
+  return distro(randGenerator());
 }
 
 